@@ -0,0 +1,113 @@
+#include "vc.h"
+using namespace vc;
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+using namespace std;
+using namespace chrono;
+
+#define ARGUMENTS 100000
+#define BUFFERS 16
+
+// the old path: one descriptor pool with maxSets = 1 per Arguments
+class PooledArguments : protected Program {
+public:
+    PooledArguments(Device &device) : Program(device, "../shaders/comp.spv", {BUFFER}) {}
+    using Program::destroy;
+
+    void createDestroy(VkBuffer buffer)
+    {
+        VkDescriptorPoolSize descriptorPoolSizes[] = {
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1}
+        };
+
+        VkDescriptorPoolCreateInfo descriptorPoolCreateInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+        descriptorPoolCreateInfo.poolSizeCount = 1;
+        descriptorPoolCreateInfo.maxSets = 1;
+        descriptorPoolCreateInfo.pPoolSizes = descriptorPoolSizes;
+        VkDescriptorPool descriptorPool;
+        if (VK_SUCCESS != vkCreateDescriptorPool(device, &descriptorPoolCreateInfo, nullptr, &descriptorPool)) {
+            throw ERROR_SHADER;
+        }
+
+        VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+        descriptorSetAllocateInfo.descriptorSetCount = 1;
+        descriptorSetAllocateInfo.pSetLayouts = &descriptorSetLayout;
+        descriptorSetAllocateInfo.descriptorPool = descriptorPool;
+        VkDescriptorSet descriptorSet;
+        if (VK_SUCCESS != vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, &descriptorSet)) {
+            throw ERROR_SHADER;
+        }
+
+        VkDescriptorBufferInfo descriptorBufferInfo = {buffer, 0, VK_WHOLE_SIZE};
+        VkWriteDescriptorSet writeDescriptorSet = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        writeDescriptorSet.dstSet = descriptorSet;
+        writeDescriptorSet.descriptorCount = 1;
+        writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        writeDescriptorSet.pBufferInfo = &descriptorBufferInfo;
+        vkUpdateDescriptorSets(device, 1, &writeDescriptorSet, 0, nullptr);
+
+        vkFreeDescriptorSets(device, descriptorPool, 1, &descriptorSet);
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    }
+};
+
+int main()
+{
+    DevicePool devicePool;
+    for (Device &device : devicePool.getDevices()) {
+        cout << "[" << device.getName() << "]" << endl;
+
+        try {
+            Program program(device, "../shaders/comp.spv", {BUFFER});
+            vector<Buffer> buffers;
+            for (int i = 0; i < BUFFERS; i++) {
+                buffers.push_back(Buffer(device, 1024));
+            }
+
+            PooledArguments pooled(device);
+            steady_clock::time_point start = steady_clock::now();
+            for (int i = 0; i < ARGUMENTS; i++) {
+                pooled.createDestroy(buffers[i % BUFFERS]);
+            }
+            long long pooledTime = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+            // rebinding one of a few buffer combinations hits the cache
+            start = steady_clock::now();
+            for (int i = 0; i < ARGUMENTS; i++) {
+                Arguments args(program, {buffers[i % BUFFERS]});
+                args.destroy();
+            }
+            long long cachedTime = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+            // every set distinct, served from pages of the shared allocator
+            start = steady_clock::now();
+            for (int i = 0; i < ARGUMENTS; i++) {
+                if (i % BUFFERS == 0) {
+                    device.resetDescriptorSets();
+                }
+                Arguments args(program, {buffers[i % BUFFERS]});
+                args.destroy();
+            }
+            long long pagedTime = duration_cast<milliseconds>(steady_clock::now() - start).count();
+
+            cout << ARGUMENTS << " arguments, pool per set: " << pooledTime << "ms" << endl;
+            cout << ARGUMENTS << " arguments, cached:       " << cachedTime << "ms" << endl;
+            cout << ARGUMENTS << " arguments, uncached:     " << pagedTime << "ms" << endl;
+
+            for (Buffer &buffer : buffers) {
+                buffer.destroy();
+            }
+            pooled.destroy();
+            program.destroy();
+            device.destroy();
+        } catch(vc::Error e) {
+            cout << "vc::Error thrown" << endl;
+            return -2;
+        }
+    }
+
+    cout << "OK" << endl;
+    return 0;
+}
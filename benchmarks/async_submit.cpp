@@ -0,0 +1,98 @@
+#include "vc.h"
+using namespace vc;
+
+#include <iostream>
+#include <chrono>
+#include <atomic>
+#include <thread>
+using namespace std;
+using namespace chrono;
+
+#define BUFFER_SIZE 10240
+#define PASSES 1000
+#define BATCHES 100
+#define HOST_WORK_US 2000
+
+// stands in for whatever the host does to prepare the next batch
+void hostWork()
+{
+    steady_clock::time_point start = steady_clock::now();
+    while (duration_cast<microseconds>(steady_clock::now() - start).count() < HOST_WORK_US);
+}
+
+int main()
+{
+    DevicePool devicePool;
+    for (Device &device : devicePool.getDevices()) {
+        cout << "[" << device.getName() << "]" << endl;
+
+        try {
+            // two independent batches so that one can be recorded while the other runs
+            Program program(device, "../shaders/comp.spv", {BUFFER});
+            Buffer buffers[2] = {Buffer(device, sizeof(double) * BUFFER_SIZE), Buffer(device, sizeof(double) * BUFFER_SIZE)};
+            Arguments args[2] = {Arguments(program, {buffers[0]}), Arguments(program, {buffers[1]})};
+            CommandBuffer commands[2] = {CommandBuffer(device, program, args[0]), CommandBuffer(device, program, args[1])};
+            for (int i = 0; i < 2; i++) {
+                buffers[i].fill(0);
+                for (int j = 0; j < PASSES; j++) {
+                    commands[i].dispatch(BUFFER_SIZE / 1024);
+                    commands[i].barrier();
+                }
+                commands[i].end();
+            }
+
+            // host work, submit, drain the queue: CPU and GPU take turns
+            steady_clock::time_point start = steady_clock::now();
+            for (int i = 0; i < BATCHES; i++) {
+                hostWork();
+                device.submit(commands[i % 2]);
+                device.wait();
+            }
+            long long serial = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+            // host work for batch N overlaps batch N - 1 on the GPU
+            Completion completions[2];
+            start = steady_clock::now();
+            for (int i = 0; i < BATCHES; i++) {
+                hostWork();
+                completions[i % 2].wait();
+                completions[i % 2] = device.submit(commands[i % 2]);
+            }
+            completions[0].wait();
+            completions[1].wait();
+            long long overlapped = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+            // completion callbacks run on the fence pool's thread
+            atomic<int> callbacks(0);
+            for (int i = 0; i < BATCHES; i++) {
+                completions[i % 2].wait();
+                completions[i % 2] = device.submit(commands[i % 2]);
+                completions[i % 2].then([&callbacks]() {
+                    callbacks++;
+                });
+            }
+            while (callbacks < BATCHES) {
+                this_thread::yield();
+            }
+
+            cout << "submit + wait: " << serial / BATCHES << "us per batch" << endl;
+            cout << "completions:   " << overlapped / BATCHES << "us per batch" << endl;
+            cout << "overlap gain:  " << (double) serial / overlapped << "x" << endl;
+            cout << "callbacks run: " << callbacks << endl;
+
+            for (int i = 0; i < 2; i++) {
+                commands[i].destroy();
+                args[i].destroy();
+                buffers[i].destroy();
+            }
+            program.destroy();
+            device.destroy();
+        } catch(vc::Error e) {
+            cout << "vc::Error thrown" << endl;
+            return -2;
+        }
+    }
+
+    cout << "OK" << endl;
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include "vc.h"
+using namespace vc;
+
+#include <iostream>
+#include <chrono>
+using namespace std;
+using namespace chrono;
+
+#define ITERATIONS 10000
+
+// the old path: one vkAllocateMemory and vkBindBufferMemory per buffer
+class DedicatedBuffers : protected Device {
+public:
+    DedicatedBuffers(Device &device) : Device(device) {}
+
+    void createDestroy(size_t byteSize)
+    {
+        VkBufferCreateInfo bufferCreateInfo = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+        bufferCreateInfo.size = byteSize;
+        bufferCreateInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        VkBuffer buffer;
+        if (VK_SUCCESS != vkCreateBuffer(device, &bufferCreateInfo, nullptr, &buffer)) {
+            throw ERROR_MALLOC;
+        }
+
+        VkMemoryRequirements memoryRequirements;
+        vkGetBufferMemoryRequirements(device, buffer, &memoryRequirements);
+
+        VkMemoryAllocateInfo memoryAllocateInfo = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+        memoryAllocateInfo.allocationSize = memoryRequirements.size;
+        memoryAllocateInfo.memoryTypeIndex = context->memoryTypeLocal;
+        VkDeviceMemory memory;
+        if (VK_SUCCESS != vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &memory)) {
+            throw ERROR_MALLOC;
+        }
+
+        if (VK_SUCCESS != vkBindBufferMemory(device, buffer, memory, 0)) {
+            throw ERROR_MALLOC;
+        }
+
+        vkDestroyBuffer(device, buffer, nullptr);
+        vkFreeMemory(device, memory, nullptr);
+    }
+};
+
+int main()
+{
+    DevicePool devicePool;
+    for (Device &device : devicePool.getDevices()) {
+        cout << "[" << device.getName() << "]" << endl;
+
+        try {
+            DedicatedBuffers dedicated(device);
+            for (size_t byteSize : {size_t(256), size_t(64 << 10), size_t(4 << 20)}) {
+                steady_clock::time_point start = steady_clock::now();
+                for (int i = 0; i < ITERATIONS; i++) {
+                    dedicated.createDestroy(byteSize);
+                }
+                double dedicatedRate = ITERATIONS / duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+                start = steady_clock::now();
+                for (int i = 0; i < ITERATIONS; i++) {
+                    Buffer buffer(device, byteSize);
+                    buffer.destroy();
+                }
+                double allocatorRate = ITERATIONS / duration_cast<duration<double>>(steady_clock::now() - start).count();
+
+                cout << byteSize << " bytes: " << dedicatedRate << " dedicated/s, "
+                     << allocatorRate << " suballocated/s (" << allocatorRate / dedicatedRate << "x)" << endl;
+            }
+
+            device.destroy();
+        } catch(vc::Error e) {
+            cout << "vc::Error thrown" << endl;
+            return -2;
+        }
+    }
+
+    cout << "OK" << endl;
+    return 0;
+}
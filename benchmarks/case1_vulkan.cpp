@@ -5,6 +5,7 @@ using namespace vc;
 #include <iostream>
 #include <iomanip>
 #include <chrono>
+#include <vector>
 using namespace std;
 using namespace chrono;
 
@@ -19,29 +20,16 @@ int main()
         cout << "[" << device.getName() << "]" << endl;
 
         try {
-            Pipeline pipeline = device.pipeline("../shaders/comp.spv", {BUFFER});
-            Buffer output = device.buffer(sizeof(double) * BUFFER_SIZE);
+            Program program(device, "../shaders/comp.spv", {BUFFER});
+            Buffer output(device, sizeof(double) * BUFFER_SIZE);
 
             // full buffer with 0 (very explicit)
-            Buffer mappable = device.mappable(sizeof(double) * BUFFER_SIZE);
-            double *inputScalars = (double *) mappable.map();
-            for (int i = 0; i < BUFFER_SIZE; i++) {
-                inputScalars[i] = 0;
-            }
-            mappable.unmap();
-
-            CommandBuffer writeCommands = device.commandBuffer();
-            writeCommands.begin();
-            writeCommands.copyBuffer(mappable, output, BUFFER_SIZE * sizeof(double));
-            writeCommands.end();
-            device.submit(writeCommands);
-            device.wait();
+            vector<double> inputScalars(BUFFER_SIZE, 0);
+            output.upload(inputScalars.data());
 
             // create a command buffer with 100k passes
-            CommandBuffer commandBuffer = device.commandBuffer();
-            commandBuffer.begin();
-            commandBuffer.bindPipeline(pipeline);
-            commandBuffer.bindResources(pipeline, {output});
+            Arguments args(program, {output});
+            CommandBuffer commandBuffer(device, program, args);
 
             steady_clock::time_point start = steady_clock::now();
             for (int i = 0; i < INCREMENT_PASSES; i++) {
@@ -58,17 +46,11 @@ int main()
                 cout << i + 1 << ": " << duration_cast<milliseconds>(steady_clock::now() - start).count() << "ms" << endl;
             }
 
-            // download results to our mappable buffer
-            CommandBuffer readCommands = device.commandBuffer();
-            readCommands.begin();
-            readCommands.copyBuffer(output, mappable, BUFFER_SIZE * sizeof(double));
-            readCommands.end();
-            device.submit(readCommands);
-            device.wait();
+            // download results
+            vector<double> outputScalars(BUFFER_SIZE);
+            output.download(outputScalars.data());
 
             // check for correctness
-            double *outputScalars = (double *) mappable.map();
-
             if (int(outputScalars[0] + 0.5) != INCREMENT_PASSES * RUNS) {
                 cout << "Mismatching result!" << endl;
                 return -3;
@@ -80,8 +62,11 @@ int main()
                     return -1;
                 }
             }
-            mappable.unmap();
 
+            commandBuffer.destroy();
+            output.destroy();
+            program.destroy();
+            device.destroy();
         } catch(vc::Error e) {
             cout << "vc::Error thrown" << endl;
             return -2;
@@ -91,4 +76,3 @@ int main()
     cout << "OK" << endl;
     return 0;
 }
-
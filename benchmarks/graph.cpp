@@ -0,0 +1,111 @@
+#include "vc.h"
+using namespace vc;
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+using namespace std;
+using namespace chrono;
+
+#define ELEMENTS (1 << 16)
+#define CHAINS 8
+#define STEPS 4
+#define RUNS 20
+
+int main()
+{
+    DevicePool devicePool;
+    for (Device &device : devicePool.getDevices()) {
+        cout << "[" << device.getName() << "]" << endl;
+
+        try {
+            Program program(device, "../shaders/comp.spv", {BUFFER});
+            size_t byteSize = sizeof(double) * ELEMENTS;
+
+            // independent chains: input, then increment and copy on to a fresh transient per step
+            vector<Buffer> inputs, outputs;
+            Graph graph(device);
+            for (int i = 0; i < CHAINS; i++) {
+                inputs.push_back(Buffer(device, byteSize));
+                outputs.push_back(Buffer(device, byteSize));
+                inputs.back().fill(0);
+
+                unsigned int previous = graph.import(inputs.back());
+                for (int j = 0; j < STEPS; j++) {
+                    unsigned int next = graph.buffer(byteSize);
+                    graph.copy(previous, next, byteSize);
+                    graph.dispatch(program, {next}, ELEMENTS / 1024);
+                    previous = next;
+                }
+                graph.copy(previous, graph.import(outputs.back()), byteSize);
+            }
+            graph.compile();
+
+            // the same work recorded in declaration order with a barrier after every node
+            vector<Buffer> transients;
+            CommandBuffer naive(device);
+            naive.begin();
+            for (int i = 0; i < CHAINS; i++) {
+                VkBuffer previous = inputs[i];
+                for (int j = 0; j < STEPS; j++) {
+                    transients.push_back(Buffer(device, byteSize));
+                    naive.copy(previous, transients.back(), byteSize);
+                    naive.barrier();
+                    Arguments args(program, {transients.back()});
+                    naive.bind(program, args);
+                    naive.dispatch(ELEMENTS / 1024);
+                    naive.barrier();
+                    previous = transients.back();
+                }
+                naive.copy(previous, outputs[i], byteSize);
+                naive.barrier();
+            }
+            naive.end();
+
+            steady_clock::time_point start = steady_clock::now();
+            for (int i = 0; i < RUNS; i++) {
+                device.submit(naive).wait();
+            }
+            long long naiveTime = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+            start = steady_clock::now();
+            for (int i = 0; i < RUNS; i++) {
+                graph.submit().wait();
+            }
+            long long graphTime = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+            // every step adds one to a copy of zeros
+            vector<double> results(ELEMENTS);
+            outputs[0].download(results.data());
+            if (results[0] != STEPS || results[ELEMENTS - 1] != STEPS) {
+                cout << "Mismatching result!" << endl;
+                return -3;
+            }
+
+            GraphReport report = graph.getReport();
+            cout << "Nodes: " << report.nodes << ", levels: " << report.levels << endl;
+            cout << "Barriers: " << report.barriers << " (" << report.barriersRemoved << " removed)" << endl;
+            cout << "Transient memory: " << report.allocatedBytes / 1024 << "kb of " << report.transientBytes / 1024
+                 << "kb (" << report.memorySaved / 1024 << "kb saved)" << endl;
+            cout << "Naive: " << naiveTime / RUNS << "us, graph: " << graphTime / RUNS << "us" << endl;
+
+            for (Buffer &buffer : transients) {
+                buffer.destroy();
+            }
+            for (int i = 0; i < CHAINS; i++) {
+                inputs[i].destroy();
+                outputs[i].destroy();
+            }
+            naive.destroy();
+            graph.destroy();
+            program.destroy();
+            device.destroy();
+        } catch(vc::Error e) {
+            cout << "vc::Error thrown" << endl;
+            return -2;
+        }
+    }
+
+    cout << "OK" << endl;
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include "vc.h"
+using namespace vc;
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+using namespace std;
+using namespace chrono;
+
+#define BUFFERS 100000
+
+int main()
+{
+    // what every object carries besides its own Vulkan handles
+    cout << "sizeof(Device): " << sizeof(Device) << endl;
+    cout << "sizeof(Buffer): " << sizeof(Buffer) << endl;
+    cout << "sizeof(Program): " << sizeof(Program) << endl;
+    cout << "sizeof(CommandBuffer): " << sizeof(CommandBuffer) << endl;
+    cout << "sizeof(Arguments): " << sizeof(Arguments) << endl;
+
+    DevicePool devicePool;
+    for (Device &device : devicePool.getDevices()) {
+        cout << "[" << device.getName() << "]" << endl;
+
+        try {
+            // freed by going out of scope, no destroy() calls
+            steady_clock::time_point start = steady_clock::now();
+            {
+                vector<Buffer> buffers;
+                buffers.reserve(BUFFERS);
+                for (int i = 0; i < BUFFERS; i++) {
+                    buffers.push_back(Buffer(device, 256));
+                }
+                cout << BUFFERS << " buffers: " << (BUFFERS * sizeof(Buffer)) / 1024 << " kB of handles" << endl;
+            }
+            cout << "Created and freed in " << duration_cast<milliseconds>(steady_clock::now() - start).count() << "ms" << endl;
+
+            // moved buffers are left empty, only the last owner frees
+            Buffer first(device, 256);
+            Buffer second(move(first));
+            first = Buffer(device, 256);
+            first.fill(1);
+            second.fill(2);
+            uint32_t values[2];
+            first.download(&values[0], sizeof(uint32_t));
+            second.download(&values[1], sizeof(uint32_t));
+            if (values[0] != 1 || values[1] != 2) {
+                cout << "Mismatching result!" << endl;
+                return -3;
+            }
+
+            second.destroy();
+            first.destroy();
+            device.destroy();
+        } catch(vc::Error e) {
+            cout << "vc::Error thrown" << endl;
+            return -2;
+        }
+    }
+
+    cout << "OK" << endl;
+    return 0;
+}
@@ -0,0 +1,122 @@
+#ifndef HARNESS_H
+#define HARNESS_H
+
+// minimal benchmark harness: repetitions, mean/stddev and CSV/JSON output
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+
+class Harness {
+private:
+    struct Row {
+        std::string device, name, unit;
+        std::vector<double> samples;
+    };
+
+    std::vector<Row> rows;
+    std::string format = "csv", output, deviceFilter;
+    int repetitions = 5;
+
+public:
+    // --repetitions N --format csv|json|text --output FILE --device SUBSTRING, text is CSV
+    // with every mean also printed to stderr as soon as it is measured
+    Harness(int argc, char **argv)
+    {
+        for (int i = 1; i + 1 < argc; i += 2) {
+            if (!strcmp(argv[i], "--repetitions")) {
+                repetitions = std::max(1, atoi(argv[i + 1]));
+            } else if (!strcmp(argv[i], "--format")) {
+                format = argv[i + 1];
+            } else if (!strcmp(argv[i], "--output")) {
+                output = argv[i + 1];
+            } else if (!strcmp(argv[i], "--device")) {
+                deviceFilter = argv[i + 1];
+            }
+        }
+    }
+
+    bool selects(const char *deviceName)
+    {
+        return deviceFilter.empty() || strstr(deviceName, deviceFilter.c_str());
+    }
+
+    static double seconds(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // run returns the seconds spent on work units of the repetition, after one warmup run
+    template <class F>
+    void measure(const std::string &device, const std::string &name, const char *unit, double work, F run)
+    {
+        run();
+        Row row = {device, name, unit};
+        for (int i = 0; i < repetitions; i++) {
+            row.samples.push_back(work / run());
+        }
+        rows.push_back(row);
+
+        if (format == "text") {
+            std::cerr << name << ": " << mean(row) << " " << unit << std::endl;
+        }
+    }
+
+    static double mean(const Row &row)
+    {
+        double sum = 0;
+        for (double sample : row.samples) {
+            sum += sample;
+        }
+        return sum / row.samples.size();
+    }
+
+    static double stddev(const Row &row)
+    {
+        double average = mean(row), sum = 0;
+        for (double sample : row.samples) {
+            sum += (sample - average) * (sample - average);
+        }
+        return row.samples.size() > 1 ? std::sqrt(sum / (row.samples.size() - 1)) : 0;
+    }
+
+    void report()
+    {
+        std::ostringstream out;
+        if (format == "json") {
+            out << "[";
+            for (size_t i = 0; i < rows.size(); i++) {
+                Row &row = rows[i];
+                out << (i ? "," : "") << "\n{\"device\":\"" << row.device << "\",\"name\":\"" << row.name
+                    << "\",\"unit\":\"" << row.unit << "\",\"repetitions\":" << row.samples.size()
+                    << ",\"mean\":" << mean(row) << ",\"stddev\":" << stddev(row)
+                    << ",\"min\":" << *std::min_element(row.samples.begin(), row.samples.end())
+                    << ",\"max\":" << *std::max_element(row.samples.begin(), row.samples.end()) << "}";
+            }
+            out << "\n]\n";
+        } else {
+            out << "device,name,unit,repetitions,mean,stddev,min,max\n";
+            for (Row &row : rows) {
+                out << "\"" << row.device << "\"," << row.name << "," << row.unit << "," << row.samples.size()
+                    << "," << mean(row) << "," << stddev(row)
+                    << "," << *std::min_element(row.samples.begin(), row.samples.end())
+                    << "," << *std::max_element(row.samples.begin(), row.samples.end()) << "\n";
+            }
+        }
+
+        if (output.size()) {
+            std::ofstream(output) << out.str();
+        } else {
+            std::cout << out.str();
+        }
+    }
+};
+
+#endif // HARNESS_H
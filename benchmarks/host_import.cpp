@@ -0,0 +1,76 @@
+#include "vc.h"
+using namespace vc;
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+using namespace std;
+using namespace chrono;
+
+#define ELEMENTS (1 << 23)
+#define RUNS 10
+
+int main()
+{
+    DevicePool devicePool;
+    for (Device &device : devicePool.getDevices()) {
+        cout << "[" << device.getName() << "]" << endl;
+
+        try {
+            // large page aligned inputs, as produced by the rest of the application
+            size_t byteSize = sizeof(double) * ELEMENTS;
+            void *host;
+            if (posix_memalign(&host, 1 << 16, byteSize)) {
+                return -4;
+            }
+            double *values = (double *) host;
+            for (int i = 0; i < ELEMENTS; i++) {
+                values[i] = 0;
+            }
+
+            Program program(device, "../shaders/comp.spv", {BUFFER});
+            Buffer staged(device, byteSize);
+            Buffer wrapped(device, host, byteSize);
+            cout << "Host memory import: " << (wrapped.isImported() ? "yes" : "no (staging fallback)") << endl;
+
+            long long times[2];
+            Buffer *buffers[2] = {&staged, &wrapped};
+            for (int i = 0; i < 2; i++) {
+                Arguments args(program, {*buffers[i]});
+                CommandBuffer commands(device, program, args);
+                commands.dispatch(ELEMENTS / 1024);
+                commands.end();
+
+                // the same round trip through both: inputs in, one pass, results out
+                steady_clock::time_point start = steady_clock::now();
+                for (int j = 0; j < RUNS; j++) {
+                    buffers[i]->upload(host);
+                    device.submit(commands).wait();
+                    buffers[i]->download(host);
+                }
+                times[i] = duration_cast<milliseconds>(steady_clock::now() - start).count();
+                commands.destroy();
+            }
+
+            if (values[0] != 2 * RUNS || values[ELEMENTS - 1] != 2 * RUNS) {
+                cout << "Mismatching result!" << endl;
+                return -3;
+            }
+
+            cout << "Staged: " << times[0] / RUNS << "ms per round trip" << endl;
+            cout << "Wrapped: " << times[1] / RUNS << "ms per round trip" << endl;
+
+            staged.destroy();
+            wrapped.destroy();
+            free(host);
+            program.destroy();
+            device.destroy();
+        } catch(vc::Error e) {
+            cout << "vc::Error thrown" << endl;
+            return -2;
+        }
+    }
+
+    cout << "OK" << endl;
+    return 0;
+}
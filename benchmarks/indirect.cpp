@@ -0,0 +1,89 @@
+#include "vc.h"
+using namespace vc;
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+using namespace std;
+using namespace chrono;
+
+#define MAX_ELEMENTS (1 << 16)
+#define ITERATIONS 1000
+
+int main()
+{
+    DevicePool devicePool;
+    for (Device &device : devicePool.getDevices()) {
+        cout << "[" << device.getName() << "]" << endl;
+
+        try {
+            // comp.spv has no bounds check, keep the buffer a multiple of its 1024 wide workgroups
+            Program program(device, "../shaders/comp.spv", {BUFFER});
+            Buffer data(device, sizeof(double) * MAX_ELEMENTS);
+            Buffer count(device, sizeof(uint32_t));
+            Buffer groups(device, sizeof(VkDispatchIndirectCommand));
+            data.fill(0);
+            Arguments args(program, {data});
+
+            // stands in for a count produced by an earlier stage
+            vector<uint32_t> counts;
+            for (int i = 0; i < ITERATIONS; i++) {
+                counts.push_back(1 + (i * 7919) % MAX_ELEMENTS);
+            }
+
+            // read the count back, record for it, submit
+            steady_clock::time_point start = steady_clock::now();
+            for (int i = 0; i < ITERATIONS; i++) {
+                count.upload(&counts[i]);
+                uint32_t n;
+                count.download(&n);
+                CommandBuffer commands(device, program, args);
+                commands.dispatch((n + 1023) / 1024);
+                commands.end();
+                device.submit(commands).wait();
+                commands.destroy();
+            }
+            long long hostTime = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+            // recorded once, the count never leaves the GPU
+            GroupCount groupCount(device);
+            CommandBuffer indirect(device);
+            indirect.begin();
+            groupCount.enqueue(indirect, count, 0, groups, 0, 1024);
+            indirect.bind(program, args);
+            indirect.dispatchIndirect(groups);
+            indirect.end();
+
+            start = steady_clock::now();
+            for (int i = 0; i < ITERATIONS; i++) {
+                count.upload(&counts[i]);
+                device.submit(indirect).wait();
+            }
+            long long indirectTime = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+            double first;
+            data.download(&first, sizeof(double));
+            if (first != 2 * ITERATIONS) {
+                cout << "Mismatching result!" << endl;
+                return -3;
+            }
+
+            cout << "Host round-trip: " << hostTime / ITERATIONS << "us per stage" << endl;
+            cout << "Indirect: " << indirectTime / ITERATIONS << "us per stage" << endl;
+
+            indirect.destroy();
+            groups.destroy();
+            count.destroy();
+            data.destroy();
+            groupCount.destroy();
+            program.destroy();
+            device.destroy();
+        } catch(vc::Error e) {
+            cout << "vc::Error thrown" << endl;
+            return -2;
+        }
+    }
+
+    cout << "OK" << endl;
+    return 0;
+}
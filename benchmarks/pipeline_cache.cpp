@@ -0,0 +1,51 @@
+#include "vc.h"
+using namespace vc;
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <sys/stat.h>
+using namespace std;
+using namespace chrono;
+
+#define PROGRAMS 20
+
+// creates the same programs as a worker would at startup, returns milliseconds
+double startup(const char *pipelineCacheDirectory)
+{
+    steady_clock::time_point start = steady_clock::now();
+    DevicePool devicePool(pipelineCacheDirectory);
+    for (Device &device : devicePool.getDevices()) {
+        for (int i = 0; i < PROGRAMS; i++) {
+            Program program(device, "../shaders/comp.spv", {BUFFER});
+        }
+    }
+    double milliseconds = duration_cast<duration<double, milli>>(steady_clock::now() - start).count();
+
+    // destroying the devices saves their pipeline caches
+    for (Device &device : devicePool.getDevices()) {
+        device.destroy();
+    }
+    return milliseconds;
+}
+
+int main()
+{
+    try {
+        char directory[] = "/tmp/vc_pipeline_cache_XXXXXX";
+        if (!mkdtemp(directory)) {
+            cout << "Cannot create cache directory" << endl;
+            return -1;
+        }
+
+        cout << "no cache:   " << startup(nullptr) << "ms" << endl;
+        cout << "cold cache: " << startup(directory) << "ms" << endl;
+        cout << "warm cache: " << startup(directory) << "ms" << endl;
+    } catch(vc::Error e) {
+        cout << "vc::Error thrown" << endl;
+        return -2;
+    }
+
+    cout << "OK" << endl;
+    return 0;
+}
@@ -0,0 +1,196 @@
+#include "vc.h"
+using namespace vc;
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+using namespace std;
+using namespace chrono;
+
+#define ELEMENTS (1 << 22)
+#define ITERATIONS 10
+
+// float sums depend on the order of additions, integers have to match exactly
+template <class T>
+bool same(T a, T b)
+{
+    return a == b || fabs((double) a - (double) b) <= 1e-4 * max(fabs((double) a), fabs((double) b));
+}
+
+template <class T>
+bool same(vector<T> &a, vector<T> &b)
+{
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!same(a[i], b[i])) {
+            cout << "Mismatching result at " << i << ": " << a[i] << " != " << b[i] << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// elements per second of the recorded commands, submitted back to back
+double gpuRate(Device &device, CommandBuffer &commands)
+{
+    steady_clock::time_point start = steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        device.submit(commands).wait();
+    }
+    return (double) ELEMENTS * ITERATIONS / duration<double>(steady_clock::now() - start).count();
+}
+
+double cpuRate(function<void()> work)
+{
+    steady_clock::time_point start = steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        work();
+    }
+    return (double) ELEMENTS * ITERATIONS / duration<double>(steady_clock::now() - start).count();
+}
+
+void print(const char *type, const char *primitive, double gpu, double cpu)
+{
+    cout << type << " " << primitive << ": " << gpu / 1e6 << " M/s (std:: " << cpu / 1e6 << " M/s)" << endl;
+}
+
+template <class T>
+bool benchmark(Device &device, Primitives &primitives, ElementType type, const char *name)
+{
+    // small signed values keep float sums exact enough, no negative zero to sort
+    vector<T> data(ELEMENTS);
+    vector<uint32_t> flags(ELEMENTS), indices(ELEMENTS);
+    for (size_t i = 0; i < data.size(); i++) {
+        data[i] = (T) ((int) ((i * 2654435761u) % 2001) - (type == U32 ? 0 : 1000)) / (type == F32 || type == F64 ? 4 : 1);
+        flags[i] = (i * 40503u) % 3 == 0;
+        indices[i] = i;
+    }
+
+    Buffer input(device, data.size() * sizeof(T)), output(device, data.size() * sizeof(T));
+    Buffer flagBuffer(device, flags.size() * sizeof(uint32_t)), survivors(device, sizeof(uint32_t));
+    Buffer values(device, indices.size() * sizeof(uint32_t));
+    input.upload(data.data());
+    flagBuffer.upload(flags.data());
+
+    // reduce
+    CommandBuffer commands(device);
+    commands.begin();
+    primitives.reduce(commands, type, input, output, ELEMENTS);
+    commands.end();
+    double gpu = gpuRate(device, commands);
+    T sum, expected = 0;
+    output.download(&sum, sizeof(T));
+    double cpu = cpuRate([&]() { expected = accumulate(data.begin(), data.end(), T(0)); });
+    if (!same(sum, expected)) {
+        cout << "Mismatching sum: " << sum << " != " << expected << endl;
+        return false;
+    }
+    print(name, "reduce", gpu, cpu);
+
+    // inclusive and exclusive scan
+    vector<T> result(ELEMENTS), reference(ELEMENTS);
+    for (int inclusive = 1; inclusive >= 0; inclusive--) {
+        commands.begin();
+        primitives.scan(commands, type, input, output, ELEMENTS, inclusive);
+        commands.end();
+        gpu = gpuRate(device, commands);
+        output.download(result.data());
+        cpu = cpuRate([&]() {
+            partial_sum(data.begin(), data.end(), reference.begin());
+            if (!inclusive) {
+                transform(reference.begin(), reference.end(), data.begin(), reference.begin(), minus<T>());
+            }
+        });
+        if (!same(result, reference)) {
+            return false;
+        }
+        print(name, inclusive ? "inclusive scan" : "exclusive scan", gpu, cpu);
+    }
+
+    // compaction
+    commands.begin();
+    primitives.compact(commands, type, input, flagBuffer, output, survivors, ELEMENTS);
+    commands.end();
+    gpu = gpuRate(device, commands);
+    uint32_t kept;
+    survivors.download(&kept);
+    output.download(result.data(), kept * sizeof(T));
+    cpu = cpuRate([&]() {
+        reference.clear();
+        for (size_t i = 0; i < data.size(); i++) {
+            if (flags[i]) {
+                reference.push_back(data[i]);
+            }
+        }
+    });
+    result.resize(kept);
+    if (kept != reference.size() || !same(result, reference)) {
+        cout << "Mismatching compaction of " << kept << " elements" << endl;
+        return false;
+    }
+    print(name, "compact", gpu, cpu);
+
+    // key/value sort, sorted keys take as long as any other
+    input.upload(data.data());
+    values.upload(indices.data());
+    commands.begin();
+    primitives.sort(commands, type, input, values, ELEMENTS);
+    commands.end();
+    device.submit(commands).wait();
+    result.resize(ELEMENTS);
+    vector<uint32_t> sortedValues(ELEMENTS);
+    input.download(result.data());
+    values.download(sortedValues.data());
+    gpu = gpuRate(device, commands);
+
+    vector<uint32_t> order;
+    cpu = cpuRate([&]() {
+        order = indices;
+        stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return data[a] < data[b]; });
+    });
+    for (size_t i = 0; i < order.size(); i++) {
+        if (sortedValues[i] != order[i] || result[i] != data[order[i]]) {
+            cout << "Mismatching sort at " << i << endl;
+            return false;
+        }
+    }
+    print(name, "sort", gpu, cpu);
+
+    commands.destroy();
+    values.destroy();
+    survivors.destroy();
+    flagBuffer.destroy();
+    output.destroy();
+    input.destroy();
+    return true;
+}
+
+int main()
+{
+    DevicePool devicePool;
+    for (Device &device : devicePool.getDevices()) {
+        cout << "[" << device.getName() << "] subgroup size " << device.getSubgroupSize()
+             << (device.hasSubgroupArithmetic() ? " with" : " without") << " arithmetic" << endl;
+
+        try {
+            // the kernels are built with make shaders
+            Primitives primitives(device, "../shaders/primitives");
+            if (!benchmark<uint32_t>(device, primitives, U32, "u32") || !benchmark<int32_t>(device, primitives, I32, "i32") ||
+                !benchmark<float>(device, primitives, F32, "f32") || (device.hasFloat64() && !benchmark<double>(device, primitives, F64, "f64"))) {
+                return -3;
+            }
+
+            primitives.destroy();
+            device.destroy();
+        } catch(vc::Error e) {
+            cout << "vc::Error thrown" << endl;
+            return -2;
+        }
+    }
+
+    cout << "OK" << endl;
+    return 0;
+}
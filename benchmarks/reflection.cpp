@@ -0,0 +1,70 @@
+#include "reflection.h"
+using namespace vc;
+
+#include <iostream>
+using namespace std;
+
+// needs no device, the modules are assembled by hand as glslang only emits LocalSizeId for
+// local_size_x_id with SPIR-V 1.2 and later targets
+
+// OpExecutionModeId %main LocalSizeId %x %y %z, %x = OpSpecConstant 64 with SpecId 3,
+// %y = OpConstant 2, %z = OpConstant 1
+static const uint32_t localSizeIdModule[] = {
+    0x07230203, 0x00010300, 0, 9, 0,
+    (2 << 16) | 17, 1,                                      // OpCapability Shader
+    (3 << 16) | 14, 0, 1,                                   // OpMemoryModel Logical GLSL450
+    (5 << 16) | 15, 5, 1, 0x6e69616d, 0,                    // OpEntryPoint GLCompute %main "main"
+    (6 << 16) | 331, 1, 38, 5, 6, 7,                        // OpExecutionModeId %main LocalSizeId %x %y %z
+    (4 << 16) | 71, 5, 1, 3,                                // OpDecorate %x SpecId 3
+    (2 << 16) | 19, 2,                                      // %void = OpTypeVoid
+    (3 << 16) | 33, 3, 2,                                   // %fn = OpTypeFunction %void
+    (4 << 16) | 21, 4, 32, 0,                               // %uint = OpTypeInt 32 0
+    (4 << 16) | 50, 4, 5, 64,                               // %x = OpSpecConstant %uint 64
+    (4 << 16) | 43, 4, 6, 2,                                // %y = OpConstant %uint 2
+    (4 << 16) | 43, 4, 7, 1,                                // %z = OpConstant %uint 1
+    (5 << 16) | 54, 2, 1, 0, 3,                             // %main = OpFunction %void None %fn
+    (2 << 16) | 248, 8,                                     // OpLabel
+    (1 << 16) | 253,                                        // OpReturn
+    (1 << 16) | 56                                          // OpFunctionEnd
+};
+
+// the same with literal sizes through OpExecutionMode %main LocalSize 32 4 1
+static const uint32_t localSizeModule[] = {
+    0x07230203, 0x00010000, 0, 9, 0,
+    (2 << 16) | 17, 1,
+    (3 << 16) | 14, 0, 1,
+    (5 << 16) | 15, 5, 1, 0x6e69616d, 0,
+    (6 << 16) | 16, 1, 17, 32, 4, 1,
+    (2 << 16) | 19, 2,
+    (3 << 16) | 33, 3, 2,
+    (5 << 16) | 54, 2, 1, 0, 3,
+    (2 << 16) | 248, 8,
+    (1 << 16) | 253,
+    (1 << 16) | 56
+};
+
+static bool check(const char *name, const uint32_t *code, size_t byteSize, uint32_t x, uint32_t y, uint32_t z, int xId)
+{
+    Reflection reflection(code, byteSize);
+    cout << name << ": local size " << reflection.localSize[0] << "," << reflection.localSize[1] << ","
+         << reflection.localSize[2] << ", spec id " << reflection.localSizeIds[0] << endl;
+    return reflection.localSize[0] == x && reflection.localSize[1] == y && reflection.localSize[2] == z &&
+           reflection.localSizeIds[0] == xId && reflection.localSizeIds[1] == -1 && reflection.localSizeIds[2] == -1;
+}
+
+int main()
+{
+    try {
+        if (!check("LocalSizeId", localSizeIdModule, sizeof(localSizeIdModule), 64, 2, 1, 3) ||
+            !check("LocalSize", localSizeModule, sizeof(localSizeModule), 32, 4, 1, -1)) {
+            cout << "Mismatching local size!" << endl;
+            return -3;
+        }
+    } catch(vc::Error e) {
+        cout << "vc::Error thrown" << endl;
+        return -2;
+    }
+
+    cout << "OK" << endl;
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include "vc.h"
+using namespace vc;
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+using namespace std;
+using namespace chrono;
+
+#define JOBS 1000
+#define SEQUENCE 8
+#define ELEMENTS (1 << 16)
+
+int main()
+{
+    DevicePool devicePool;
+    for (Device &device : devicePool.getDevices()) {
+        cout << "[" << device.getName() << "]" << endl;
+
+        try {
+            // comp.spv increments 1024 doubles per workgroup
+            Program program(device, "../shaders/comp.spv", {BUFFER});
+            Buffer data(device, sizeof(double) * ELEMENTS);
+            data.fill(0);
+            Arguments args(program, {data});
+
+            // command pools are created up front, only recording and submission is timed
+            vector<CommandBuffer> jobs;
+            for (int i = 0; i < JOBS; i++) {
+                jobs.push_back(CommandBuffer(device));
+            }
+
+            // every job records the kernel sequence again and is submitted on its own
+            steady_clock::time_point start = steady_clock::now();
+            Completion completion;
+            for (CommandBuffer &job : jobs) {
+                job.begin();
+                job.bind(program, args);
+                for (int i = 0; i < SEQUENCE; i++) {
+                    job.dispatch(ELEMENTS / 1024);
+                }
+                job.end();
+                completion = device.submit(job);
+            }
+            double rerecordCpu = duration<double, micro>(steady_clock::now() - start).count();
+            completion.wait();
+            double rerecordTotal = duration<double, micro>(steady_clock::now() - start).count();
+
+            // the sequence recorded once, jobs only execute it and go out in one submit
+            CommandBuffer sequence(device, true);
+            sequence.begin();
+            sequence.bind(program, args);
+            for (int i = 0; i < SEQUENCE; i++) {
+                sequence.dispatch(ELEMENTS / 1024);
+            }
+            sequence.end();
+
+            start = steady_clock::now();
+            vector<VkCommandBuffer> batch;
+            for (CommandBuffer &job : jobs) {
+                job.begin();
+                job.execute(sequence);
+                job.end();
+                batch.push_back(job);
+            }
+            completion = device.submit(batch);
+            double secondaryCpu = duration<double, micro>(steady_clock::now() - start).count();
+            completion.wait();
+            double secondaryTotal = duration<double, micro>(steady_clock::now() - start).count();
+
+            double first;
+            data.download(&first, sizeof(double));
+            if (first != 2 * JOBS * SEQUENCE) {
+                cout << "Mismatching result: " << first << endl;
+                return -3;
+            }
+
+            cout << "Re-recorded, one submit per job: " << rerecordCpu / JOBS << "us CPU per job, "
+                 << rerecordTotal / JOBS << "us total" << endl;
+            cout << "Secondary, one batched submit: " << secondaryCpu / JOBS << "us CPU per job, "
+                 << secondaryTotal / JOBS << "us total" << endl;
+
+            sequence.destroy();
+            for (CommandBuffer &job : jobs) {
+                job.destroy();
+            }
+            data.destroy();
+            program.destroy();
+            device.destroy();
+        } catch(vc::Error e) {
+            cout << "vc::Error thrown" << endl;
+            return -2;
+        }
+    }
+
+    cout << "OK" << endl;
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include "vc.h"
+using namespace vc;
+
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+using namespace std;
+using namespace chrono;
+
+#define BUFFER_SIZE (1024 * 1024)
+#define RUNS 5
+
+// usage: sharded [logical shards per device]
+int main(int argc, char **argv)
+{
+    unsigned int shardsPerDevice = argc > 1 ? atoi(argv[1]) : 1;
+
+    try {
+        DevicePool devicePool;
+        ShardedDispatch sharded(devicePool, "../shaders/comp.spv", {BUFFER}, shardsPerDevice);
+        cout << sharded.getShardCount() << " shards on " << devicePool.getDevices().size() << " devices" << endl;
+
+        vector<double> data(BUFFER_SIZE, 0.0);
+        vector<ShardedBuffer> buffers = {{data.data(), sizeof(double), true, true}};
+
+        sharded.calibrate(BUFFER_SIZE, 1, buffers, 1024);
+        cout << "calibrated weights:";
+        for (double weight : sharded.getWeights()) {
+            cout << " " << weight;
+        }
+        cout << endl;
+
+        for (int i = 0; i < RUNS; i++) {
+            steady_clock::time_point start = steady_clock::now();
+            sharded.dispatch(BUFFER_SIZE, 1, buffers, 1024);
+            cout << duration_cast<milliseconds>(steady_clock::now() - start).count() << "ms" << endl;
+        }
+
+        // calibration counts as one pass
+        for (int i = 0; i < BUFFER_SIZE; i++) {
+            if (data[i] != RUNS + 1) {
+                cout << "Mismatch at " << i << ": " << data[i] << endl;
+                return -1;
+            }
+        }
+
+        sharded.destroy();
+        for (Device &device : devicePool.getDevices()) {
+            device.destroy();
+        }
+    } catch(vc::Error e) {
+        cout << "vc::Error thrown" << endl;
+        return -2;
+    }
+
+    cout << "OK" << endl;
+    return 0;
+}
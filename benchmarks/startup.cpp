@@ -0,0 +1,82 @@
+#include "vc.h"
+using namespace vc;
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+using namespace std;
+using namespace chrono;
+
+double elapsed(steady_clock::time_point start)
+{
+    return duration<double, milli>(steady_clock::now() - start).count();
+}
+
+const char *typeName(VkPhysicalDeviceType type)
+{
+    switch (type) {
+    case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+        return "discrete";
+    case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+        return "integrated";
+    case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+        return "virtual";
+    case VK_PHYSICAL_DEVICE_TYPE_CPU:
+        return "cpu";
+    default:
+        return "other";
+    }
+}
+
+int main()
+{
+    try {
+        // enumeration alone, no logical device yet
+        steady_clock::time_point start = steady_clock::now();
+        DevicePool devicePool;
+        cout << "Enumeration: " << elapsed(start) << " ms" << endl;
+
+        const vector<PhysicalDeviceInfo> &physicalDevices = devicePool.getPhysicalDevices();
+        for (const PhysicalDeviceInfo &info : physicalDevices) {
+            cout << "[" << info.properties.deviceName << "] " << typeName(info.properties.deviceType)
+                 << ", " << (info.deviceLocalMemory >> 20) << " MB device local, "
+                 << info.queueFamilies.size() << " queue families" << endl;
+        }
+
+        // what an application using one device pays before its first dispatch
+        start = steady_clock::now();
+        Device &first = devicePool.getDevice(0);
+        cout << "First device [" << first.getName() << "]: " << elapsed(start) << " ms" << endl;
+
+        // the rest in parallel, the first one is reused
+        start = steady_clock::now();
+        vector<Device> &devices = devicePool.getDevices();
+        cout << "Remaining " << devices.size() - 1 << " devices in parallel: " << elapsed(start) << " ms" << endl;
+
+        DeviceFilter filter = {};
+        filter.queueFlags = VK_QUEUE_COMPUTE_BIT;
+        filter.deviceTypes = {VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU, VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU};
+        cout << devicePool.getDevices(filter).size() << " of " << physicalDevices.size() << " devices are compute capable GPUs" << endl;
+
+        // one after the other for comparison, like the pool used to do it
+        start = steady_clock::now();
+        vector<Device> serial;
+        for (const PhysicalDeviceInfo &info : physicalDevices) {
+            serial.push_back(Device(info.physicalDevice));
+        }
+        cout << "All " << serial.size() << " devices serially: " << elapsed(start) << " ms" << endl;
+
+        for (Device &device : serial) {
+            device.destroy();
+        }
+        for (Device &device : devices) {
+            device.destroy();
+        }
+    } catch(vc::Error e) {
+        cout << "vc::Error thrown" << endl;
+        return -1;
+    }
+
+    cout << "OK" << endl;
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include "vc.h"
+using namespace vc;
+
+#include <iostream>
+#include <vector>
+using namespace std;
+
+#define ELEMENTS (32 << 20)
+
+int main()
+{
+    DevicePool devicePool;
+    for (Device &device : devicePool.getDevices()) {
+        cout << "[" << device.getName() << "]" << endl;
+
+        try {
+            // comp.spv increments 1024 doubles per workgroup in place
+            Program program(device, "../shaders/comp.spv", {BUFFER});
+            vector<double> data(ELEMENTS, 0);
+            size_t byteSize = data.size() * sizeof(double);
+
+            int runs = 0;
+            for (size_t chunkSize = 1 << 20; chunkSize <= (64 << 20); chunkSize *= 4) {
+                StreamExecutor executor(device, program, chunkSize, 1024 * sizeof(double));
+                executor.run(data.data(), byteSize, data.data(), byteSize);
+                runs++;
+                cout << chunkSize / 1024 << "kb chunks: " << executor.getThroughput() / 1e6 << " MB/s" << endl;
+                executor.destroy();
+            }
+
+            for (size_t i = 0; i < data.size(); i += 4096) {
+                if (data[i] != runs) {
+                    cout << "Mismatching result at " << i << ": " << data[i] << endl;
+                    return -3;
+                }
+            }
+
+            program.destroy();
+            device.destroy();
+        } catch(vc::Error e) {
+            cout << "vc::Error thrown" << endl;
+            return -2;
+        }
+    }
+
+    cout << "OK" << endl;
+    return 0;
+}
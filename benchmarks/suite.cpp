@@ -0,0 +1,155 @@
+#include "vc.h"
+using namespace vc;
+
+#include "harness.h"
+#include <vector>
+#include <string>
+using namespace std;
+using namespace chrono;
+
+// sizes stay small enough for software drivers such as lavapipe
+#define SUBMITS 200
+#define DISPATCHES 10000
+#define RECORDED_COMMANDS 100000
+#define DESCRIPTOR_SETS 10000
+#define DESCRIPTOR_BUFFERS 64
+#define KERNEL_ELEMENTS (1 << 20)
+#define KERNEL_PASSES 50
+
+static const size_t transferSizes[] = {4 << 10, 64 << 10, 1 << 20, 16 << 20};
+
+int main(int argc, char **argv)
+{
+    Harness harness(argc, argv);
+
+    DevicePool devicePool;
+    for (Device &device : devicePool.getDevices()) {
+        if (!harness.selects(device.getName())) {
+            continue;
+        }
+        string name = device.getName();
+
+        try {
+            Program program(device, "../shaders/comp.spv", {BUFFER});
+            Buffer buffer(device, sizeof(double) * KERNEL_ELEMENTS);
+            buffer.fill(0);
+            Arguments args(program, {buffer});
+
+            // round trip of one tiny dispatch: submission and completion latency
+            CommandBuffer single(device, program, args);
+            single.dispatch(1);
+            single.end();
+            harness.measure(name, "submit_latency", "us/submit", SUBMITS * 1e6, [&]() {
+                steady_clock::time_point start = steady_clock::now();
+                for (int i = 0; i < SUBMITS; i++) {
+                    device.submit(single).wait();
+                }
+                return Harness::seconds(start);
+            });
+
+            // many tiny dispatches in one submission: per-dispatch cost on the device
+            CommandBuffer many(device, program, args);
+            for (int i = 0; i < DISPATCHES; i++) {
+                many.dispatch(1);
+                many.barrier();
+            }
+            many.end();
+            harness.measure(name, "dispatch_overhead", "us/dispatch", DISPATCHES * 1e6, [&]() {
+                steady_clock::time_point start = steady_clock::now();
+                device.submit(many).wait();
+                return Harness::seconds(start);
+            });
+
+            // host side cost of recording dispatches and barriers
+            CommandBuffer recording(device);
+            harness.measure(name, "record_rate", "Mcommands/s", RECORDED_COMMANDS * 2 / 1e6, [&]() {
+                steady_clock::time_point start = steady_clock::now();
+                recording.begin();
+                program.bindTo(recording);
+                args.bindTo(recording);
+                for (int i = 0; i < RECORDED_COMMANDS; i++) {
+                    recording.dispatch(1);
+                    recording.barrier();
+                }
+                recording.end();
+                return Harness::seconds(start);
+            });
+
+            // distinct descriptor sets, each written and bound once. Pools are only reset once the
+            // recording that binds their sets has ended, resetting them earlier invalidates it
+            vector<Buffer> buffers;
+            for (int i = 0; i < DESCRIPTOR_BUFFERS; i++) {
+                buffers.push_back(Buffer(device, 256));
+            }
+            harness.measure(name, "descriptor_bind", "us/set", DESCRIPTOR_SETS * 1e6, [&]() {
+                steady_clock::time_point start = steady_clock::now();
+                for (int i = 0; i < DESCRIPTOR_SETS; ) {
+                    recording.begin();
+                    program.bindTo(recording);
+                    for (int j = 0; j < DESCRIPTOR_BUFFERS && i < DESCRIPTOR_SETS; j++, i++) {
+                        Arguments bound(program, {buffers[j]});
+                        bound.bindTo(recording);
+                    }
+                    recording.end();
+                    device.resetDescriptorSets();
+                }
+                return Harness::seconds(start);
+            });
+            device.resetDescriptorSets();
+            args = Arguments(program, {buffer});
+
+            // host to device and back, per direction and size
+            vector<char> host(transferSizes[sizeof(transferSizes) / sizeof(size_t) - 1]);
+            Buffer transfer(device, host.size());
+            for (size_t size : transferSizes) {
+                int count = max<int>(1, (64 << 20) / size);
+                harness.measure(name, "upload_" + to_string(size), "MB/s", count * size / 1e6, [&]() {
+                    steady_clock::time_point start = steady_clock::now();
+                    for (int i = 0; i < count; i++) {
+                        transfer.upload(host.data(), size);
+                    }
+                    device.wait();
+                    return Harness::seconds(start);
+                });
+                harness.measure(name, "download_" + to_string(size), "MB/s", count * size / 1e6, [&]() {
+                    steady_clock::time_point start = steady_clock::now();
+                    for (int i = 0; i < count; i++) {
+                        transfer.download(host.data(), size);
+                    }
+                    return Harness::seconds(start);
+                });
+            }
+            transfer.destroy();
+
+            // the increment kernel reads and writes one double per invocation
+            CommandBuffer kernel(device, program, args);
+            for (int i = 0; i < KERNEL_PASSES; i++) {
+                kernel.dispatch(KERNEL_ELEMENTS / 1024);
+                kernel.barrier();
+            }
+            kernel.end();
+            harness.measure(name, "kernel_throughput", "GB/s", 2.0 * sizeof(double) * KERNEL_ELEMENTS * KERNEL_PASSES / 1e9, [&]() {
+                steady_clock::time_point start = steady_clock::now();
+                device.submit(kernel).wait();
+                return Harness::seconds(start);
+            });
+
+            for (Buffer &b : buffers) {
+                b.destroy();
+            }
+            kernel.destroy();
+            recording.destroy();
+            many.destroy();
+            single.destroy();
+            buffer.destroy();
+            program.destroy();
+            device.destroy();
+        } catch(vc::Error e) {
+            cerr << "vc::Error thrown" << endl;
+            return -2;
+        }
+    }
+
+    harness.report();
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "vc.h"
+using namespace vc;
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+using namespace std;
+using namespace chrono;
+
+#define STRESS_ITERATIONS 200
+#define SUBMITS_PER_THREAD 2000
+#define ELEMENTS 4096
+
+// every thread fills, dispatches on, uploads to and downloads its own buffer, all
+// through the shared device, checking what comes back each time
+bool stress(Device &device, Program &program, unsigned int numThreads)
+{
+    atomic<bool> failed(false);
+    vector<thread> threads;
+    for (unsigned int t = 0; t < numThreads; t++) {
+        threads.push_back(thread([&, t]() {
+            try {
+                Buffer buffer(device, sizeof(double) * ELEMENTS);
+                Arguments args(program, {buffer});
+                CommandBuffer commands(device, program, args);
+                commands.dispatch(ELEMENTS / 1024);
+                commands.end();
+
+                vector<double> data(ELEMENTS);
+                for (int i = 0; i < STRESS_ITERATIONS && !failed; i++) {
+                    buffer.fill(0);
+                    device.submit(commands, t % device.getComputeQueueCount()).wait();
+                    buffer.download(data.data());
+                    if (data[t % ELEMENTS] != 1) {
+                        cout << "Thread " << t << " read " << data[t % ELEMENTS] << " after fill and dispatch" << endl;
+                        failed = true;
+                    }
+
+                    data.assign(ELEMENTS, t + i);
+                    buffer.upload(data.data());
+                    data.assign(ELEMENTS, 0);
+                    buffer.download(data.data());
+                    if (data[ELEMENTS - 1] != t + i) {
+                        cout << "Thread " << t << " read back " << data[ELEMENTS - 1] << " instead of " << t + i << endl;
+                        failed = true;
+                    }
+                }
+
+                commands.destroy();
+                buffer.destroy();
+            } catch(vc::Error e) {
+                cout << "vc::Error thrown in thread " << t << endl;
+                failed = true;
+            }
+        }));
+    }
+
+    for (thread &t : threads) {
+        t.join();
+    }
+    return !failed;
+}
+
+// small one-off submissions per second, recorded on per-thread pools
+double scaling(Device &device, unsigned int numThreads)
+{
+    Buffer buffer(device, sizeof(uint32_t) * numThreads);
+    vector<thread> threads;
+    steady_clock::time_point start = steady_clock::now();
+    for (unsigned int t = 0; t < numThreads; t++) {
+        threads.push_back(thread([&, t]() {
+            for (int i = 0; i < SUBMITS_PER_THREAD; i++) {
+                VkCommandBuffer commandBuffer = device.acquireCommandBuffer();
+                vkCmdFillBuffer(commandBuffer, buffer, t * sizeof(uint32_t), sizeof(uint32_t), i);
+                device.submitAcquired(commandBuffer).wait();
+            }
+        }));
+    }
+
+    for (thread &t : threads) {
+        t.join();
+    }
+    double seconds = duration<double>(steady_clock::now() - start).count();
+    buffer.destroy();
+    return numThreads * SUBMITS_PER_THREAD / seconds;
+}
+
+int main()
+{
+    DevicePool devicePool;
+    for (Device &device : devicePool.getDevices()) {
+        cout << "[" << device.getName() << "]" << endl;
+
+        try {
+            // comp.spv increments 1024 doubles per workgroup
+            Program program(device, "../shaders/comp.spv", {BUFFER});
+            for (unsigned int numThreads = 1; numThreads <= 16; numThreads *= 2) {
+                if (!stress(device, program, numThreads)) {
+                    return -3;
+                }
+            }
+
+            for (unsigned int numThreads = 1; numThreads <= 16; numThreads *= 2) {
+                cout << numThreads << " threads: " << scaling(device, numThreads) << " submits/s" << endl;
+            }
+
+            program.destroy();
+            device.destroy();
+        } catch(vc::Error e) {
+            cout << "vc::Error thrown" << endl;
+            return -2;
+        }
+    }
+
+    cout << "OK" << endl;
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include "vc.h"
+using namespace vc;
+
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+using namespace std;
+using namespace chrono;
+
+#define CHAIN 256
+#define ELEMENTS (1 << 20)
+
+int main()
+{
+    DevicePool devicePool;
+    for (Device &device : devicePool.getDevices()) {
+        cout << "[" << device.getName() << "]" << endl;
+        if (!device.hasTimelineSemaphores()) {
+            cout << "No timeline semaphores, skipping" << endl;
+            device.destroy();
+            continue;
+        }
+
+        try {
+            // comp.spv increments 1024 doubles per workgroup
+            Program program(device, "../shaders/comp.spv", {BUFFER});
+            Buffer data(device, sizeof(double) * ELEMENTS);
+            data.fill(0);
+            Arguments args(program, {data});
+            CommandBuffer commands(device, program, args);
+            commands.dispatch(ELEMENTS / 1024);
+            commands.end();
+
+            // the host waits for every link before submitting the next one
+            steady_clock::time_point start = steady_clock::now();
+            for (int i = 0; i < CHAIN; i++) {
+                device.submit(commands).wait();
+            }
+            long long hostTime = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+            // the whole chain queued ahead, alternating between compute queues
+            start = steady_clock::now();
+            SyncPoint last = {};
+            for (int i = 0; i < CHAIN; i++) {
+                last = device.enqueue(commands, i ? vector<SyncPoint>{last} : vector<SyncPoint>{}, i % device.getComputeQueueCount());
+            }
+            device.wait(last);
+            long long chainedTime = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+            // queued behind a host signal, nothing may run before it
+            Timeline gate(device);
+            last = device.enqueue(commands, {gate.at(1)});
+            this_thread::sleep_for(milliseconds(50));
+            if (device.wait(last, 0)) {
+                cout << "Chain started before the host signal!" << endl;
+                return -3;
+            }
+            gate.signal(1);
+            device.wait(last);
+
+            double first;
+            data.download(&first, sizeof(double));
+            if (first != 2 * CHAIN + 1) {
+                cout << "Mismatching result: " << first << endl;
+                return -3;
+            }
+
+            cout << "Host sync between submits: " << hostTime / CHAIN << "us per link" << endl;
+            cout << "Timeline chain: " << chainedTime / CHAIN << "us per link" << endl;
+
+            gate.destroy();
+            commands.destroy();
+            data.destroy();
+            program.destroy();
+            device.destroy();
+        } catch(vc::Error e) {
+            cout << "vc::Error thrown" << endl;
+            return -2;
+        }
+    }
+
+    cout << "OK" << endl;
+    return 0;
+}
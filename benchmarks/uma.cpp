@@ -0,0 +1,81 @@
+#include "vc.h"
+using namespace vc;
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+using namespace std;
+using namespace chrono;
+
+#define TOTAL_BYTES (256 << 20)
+
+// the old path: always through the staging ring, even when the buffer is mapped
+class StagedTransfer : protected Device {
+public:
+    StagedTransfer(Device &device) : Device(device) {}
+
+    void upload(VkBuffer buffer, const void *hostPtr, size_t byteSize)
+    {
+        context->stagingRing->upload(buffer, hostPtr, byteSize, 0);
+    }
+
+    void download(VkBuffer buffer, void *hostPtr, size_t byteSize)
+    {
+        context->stagingRing->download(buffer, hostPtr, byteSize, 0);
+    }
+};
+
+int main()
+{
+    DevicePool devicePool;
+    for (Device &device : devicePool.getDevices()) {
+        cout << "[" << device.getName() << "]" << endl;
+        cout << "Unified memory: " << (device.hasUnifiedMemory() ? "yes" : "no") << endl;
+
+        try {
+            StagedTransfer staged(device);
+            for (size_t size = 64 << 10; size <= (64 << 20); size *= 16) {
+                Buffer buffer(device, size);
+                vector<char> host(size, 1);
+                int count = TOTAL_BYTES / size;
+
+                steady_clock::time_point start = steady_clock::now();
+                for (int i = 0; i < count; i++) {
+                    staged.upload(buffer, host.data(), size);
+                }
+                device.wait();
+                double stagedUpload = TOTAL_BYTES / 1e6 / duration<double>(steady_clock::now() - start).count();
+
+                start = steady_clock::now();
+                for (int i = 0; i < count; i++) {
+                    buffer.upload(host.data(), size);
+                }
+                device.wait();
+                double directUpload = TOTAL_BYTES / 1e6 / duration<double>(steady_clock::now() - start).count();
+
+                start = steady_clock::now();
+                for (int i = 0; i < count; i++) {
+                    staged.download(buffer, host.data(), size);
+                }
+                double stagedDownload = TOTAL_BYTES / 1e6 / duration<double>(steady_clock::now() - start).count();
+
+                start = steady_clock::now();
+                for (int i = 0; i < count; i++) {
+                    buffer.download(host.data(), size);
+                }
+                double directDownload = TOTAL_BYTES / 1e6 / duration<double>(steady_clock::now() - start).count();
+
+                cout << size / 1024 << "kb upload: " << stagedUpload << " MB/s staged, " << directUpload << " MB/s direct" << endl;
+                cout << size / 1024 << "kb download: " << stagedDownload << " MB/s staged, " << directDownload << " MB/s direct" << endl;
+                buffer.destroy();
+            }
+            device.destroy();
+        } catch(vc::Error e) {
+            cout << "vc::Error thrown" << endl;
+            return -2;
+        }
+    }
+
+    cout << "OK" << endl;
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "vc.h"
+using namespace vc;
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+using namespace std;
+using namespace chrono;
+
+#define SLICES 1024
+#define SLICE 1024
+#define ITERATIONS 10
+
+// microseconds to record with record() and to run the result ITERATIONS times
+template <class F>
+void measure(Device &device, CommandBuffer &commands, const char *name, F record)
+{
+    steady_clock::time_point start = steady_clock::now();
+    commands.begin();
+    record();
+    commands.end();
+    double recording = duration<double, micro>(steady_clock::now() - start).count();
+
+    start = steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        device.submit(commands).wait();
+    }
+    double running = duration<double, micro>(steady_clock::now() - start).count() / ITERATIONS;
+    cout << name << ": " << recording << "us to record, " << running << "us to run, "
+         << commands.getBarrierCount() << " barriers" << endl;
+}
+
+int main()
+{
+    DevicePool devicePool;
+    for (Device &device : devicePool.getDevices()) {
+        cout << "[" << device.getName() << "]" << endl;
+
+        try {
+            // comp.spv increments 1024 doubles per workgroup, one workgroup per slice
+            Program program(device, "../shaders/comp.spv", {BUFFER});
+            Program dynamicProgram(device, "../shaders/comp.spv", {BUFFER_DYNAMIC});
+            CommandBuffer commands(device);
+
+            // the old way, a buffer and a descriptor set per slice
+            vector<Buffer> slices;
+            vector<Arguments> sliceArguments;
+            for (int i = 0; i < SLICES; i++) {
+                slices.push_back(Buffer(device, SLICE * sizeof(double)));
+                slices.back().fill(0);
+                sliceArguments.push_back(Arguments(program, {slices.back()}));
+            }
+            measure(device, commands, "Buffer per slice", [&]() {
+                for (int i = 0; i < SLICES; i++) {
+                    commands.bind(program, sliceArguments[i]);
+                    commands.dispatch();
+                }
+            });
+
+            // one buffer and one set, the window moves with every bind
+            TypedBuffer<double> data(device, SLICES * SLICE);
+            data.fill(0);
+            Arguments window(dynamicProgram, {data.view(0, SLICE)});
+            measure(device, commands, "Dynamic offsets", [&]() {
+                for (int i = 0; i < SLICES; i++) {
+                    commands.bind(dynamicProgram, window, {data.offsetOf(i * SLICE)});
+                    commands.dispatch();
+                }
+            });
+
+            vector<double> results(data.count());
+            data.download(results);
+            for (double result : results) {
+                if (result != ITERATIONS) {
+                    cout << "Mismatching result!" << endl;
+                    return -3;
+                }
+            }
+
+            // reverse the order of the slices, a copy per slice against one copy of all of them
+            TypedBuffer<double> reversed(device, SLICES * SLICE);
+            vector<VkBufferCopy> regions;
+            for (int i = 0; i < SLICES; i++) {
+                regions.push_back({data.offsetOf(i * SLICE), reversed.offsetOf((SLICES - 1 - i) * SLICE), SLICE * sizeof(double)});
+            }
+            measure(device, commands, "Copy per slice", [&]() {
+                for (VkBufferCopy &region : regions) {
+                    commands.copy(data, reversed, region.size, region.srcOffset, region.dstOffset);
+                }
+            });
+            measure(device, commands, "Batched copy", [&]() {
+                commands.copy(data, reversed, regions);
+            });
+
+            reversed.fill(0);
+            device.submit(commands).wait();
+            reversed.download(results);
+            for (double result : results) {
+                if (result != ITERATIONS) {
+                    cout << "Mismatching copy!" << endl;
+                    return -3;
+                }
+            }
+
+            reversed.destroy();
+            data.destroy();
+            for (Buffer &slice : slices) {
+                slice.destroy();
+            }
+            commands.destroy();
+            dynamicProgram.destroy();
+            program.destroy();
+            device.destroy();
+        } catch(vc::Error e) {
+            cout << "vc::Error thrown" << endl;
+            return -2;
+        }
+    }
+
+    cout << "OK" << endl;
+    return 0;
+}
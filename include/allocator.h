@@ -0,0 +1,47 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include "device.h"
+#include <vector>
+#include <map>
+#include <mutex>
+
+namespace vc {
+
+struct Allocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize memorySize = 0, offset = 0, size = 0;
+    char *mapped = nullptr;
+    uint32_t memoryType = 0;
+    int sizeClass = -1;
+};
+
+// carves large blocks per memory type into power of two size classes,
+// freed suballocations go back on the free list of their class
+class Allocator : protected Device {
+private:
+    struct Block {
+        VkDeviceMemory memory;
+        VkDeviceSize size, used;
+        char *mapped;
+    };
+
+    std::mutex mutex;
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    std::map<uint32_t, std::vector<Block>> blocks;
+    std::map<std::pair<uint32_t, int>, std::vector<Allocation>> freeLists;
+    VkDeviceSize blockSize;
+
+    VkDeviceMemory allocateMemory(uint32_t memoryType, VkDeviceSize size, char **mapped);
+    void carve(uint32_t memoryType, int sizeClass);
+
+public:
+    Allocator(Device &device, VkDeviceSize blockSize = 64 << 20);
+    Allocation allocate(uint32_t memoryType, VkMemoryRequirements memoryRequirements);
+    void free(Allocation allocation);
+    void destroy();
+};
+
+}
+
+#endif // ALLOCATOR_H
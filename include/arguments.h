@@ -7,18 +7,37 @@
 
 namespace vc {
 
-class Arguments : protected Program {
+// the descriptor set is owned by the device's descriptor allocator, so this only refers to
+// it and the layout of the program it was made for, which has to outlive it
+class Arguments : protected Device {
+    friend class CommandBuffer;
+
 private:
-    VkDescriptorPool descriptorPool;
+    VkPipelineLayout pipelineLayout;
+    VkDescriptorSetLayout descriptorSetLayout;
     VkDescriptorSet descriptorSet;
+    uint64_t generation;
+    std::vector<BufferView> resources;
+    std::vector<ResourceType> resourceTypes;
+    unsigned int numDynamic = 0;
+
+    void allocate();
 
 public:
-    Arguments(Program &function, std::vector<Buffer> resources);
-    void bindTo(VkCommandBuffer commandBuffer);
+    // buffers are bound whole, views just their range. For BUFFER_DYNAMIC resources the view is
+    // the window at dynamic offset 0, it needs an explicit size and has to come from a Buffer
+    // (or carry the buffer size). Offsets have to be multiples of minStorageBufferOffsetAlignment
+    // and keep the window within the buffer
+    Arguments(Program &function, std::vector<BufferView> resources);
+    Arguments(const Arguments &arguments) = delete;
+    Arguments(Arguments &&arguments) = default;
+    Arguments &operator=(const Arguments &arguments) = delete;
+    Arguments &operator=(Arguments &&arguments) = default;
+    // one offset per BUFFER_DYNAMIC resource in binding order, none binds them all at 0
+    void bindTo(VkCommandBuffer commandBuffer, std::vector<uint32_t> dynamicOffsets = {});
     void destroy();
 };
 
 }
 
 #endif // ARGUMENTS_H
-
@@ -3,24 +3,68 @@
 
 #include "device.h"
 #include "commandbuffer.h"
+#include "allocator.h"
 #include <cstring>
+#include <vector>
 
 namespace vc {
 
+class Buffer;
+
+// a byte range of a buffer, bound in place of all of it. Buffers convert to a view of
+// everything they hold. bufferSize is the size of the whole buffer, VK_WHOLE_SIZE where
+// it isn't known, as for plain VkBuffers
+struct BufferView {
+    VkBuffer buffer;
+    VkDeviceSize offset, size, bufferSize;
+
+    BufferView(VkBuffer buffer);
+    BufferView(Buffer &buffer);
+    BufferView(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, VkDeviceSize bufferSize = VK_WHOLE_SIZE);
+};
+
 class Buffer : protected Device {
 private:
-    VkDeviceMemory memory;
+    Allocation allocation;
     VkBuffer buffer;
+    size_t byteSize;
+    bool imported = false;
+    void createBuffer(const void *next);
+    bool importHostMemory(void *hostPtr);
+    VkMappedMemoryRange mappedRange(size_t offset, size_t byteSize);
 
 public:
     Buffer(Device &device, size_t byteSize, bool mappable = false);
+
+    // wraps page aligned host memory without copies when the device supports importing it,
+    // otherwise a device buffer that upload and download with the same pointer stage through
+    Buffer(Device &device, void *hostPtr, size_t byteSize);
+
+    // move-only, the memory goes back to the allocator when the owning Buffer is destroyed
+    Buffer(const Buffer &buffer) = delete;
+    Buffer(Buffer &&buffer) noexcept;
+    Buffer &operator=(const Buffer &buffer) = delete;
+    Buffer &operator=(Buffer &&buffer) noexcept;
+    ~Buffer();
     void fill(uint32_t value);
-    void enqueueCopy(Buffer src, Buffer dst, size_t byteSize, VkCommandBuffer commandBuffer);
-    void download(void *hostPtr);
+    void enqueueCopy(Buffer &src, Buffer &dst, size_t byteSize, VkCommandBuffer commandBuffer);
+
+    // any number of regions in one vkCmdCopyBuffer
+    void enqueueCopy(Buffer &src, Buffer &dst, std::vector<VkBufferCopy> regions, VkCommandBuffer commandBuffer);
+    // both are ordered after compute work submitted before them, whatever the memory type
+    void upload(const void *hostPtr, size_t byteSize = VK_WHOLE_SIZE, size_t offset = 0);
+    void download(void *hostPtr, size_t byteSize = VK_WHOLE_SIZE, size_t offset = 0);
+    size_t size();
+
+    // byteSize bytes from offset, VK_WHOLE_SIZE for the rest of the buffer
+    BufferView view(size_t offset = 0, size_t byteSize = VK_WHOLE_SIZE);
+    bool isImported();
     operator VkBuffer();
     void destroy();
     void unmap();
     void *map();
+    void flush(size_t offset, size_t byteSize);
+    void invalidate(size_t offset, size_t byteSize);
 };
 
 }
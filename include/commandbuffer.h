@@ -3,27 +3,104 @@
 
 #include "device.h"
 #include <vector>
+#include <map>
+#include <ostream>
+#include <type_traits>
 
 namespace vc {
 
 class Program;
 class Arguments;
+class Buffer;
+class Profiler;
+struct ProfileEntry;
 
 class CommandBuffer : protected Device {
+    friend class Primitives;
+
 private:
-    VkCommandBuffer commandBuffer;
-    VkCommandPool commandPool;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    uint32_t pushConstantSize = 0;
+    Profiler *profiler = nullptr;
+
+    // buffer accesses not yet covered by a barrier, writes also remember who they were made visible to
+    struct Range {
+        VkDeviceSize offset, size;
+        VkPipelineStageFlags stage;
+        VkAccessFlags access;
+        bool write;
+        VkPipelineStageFlags visibleStage;
+        VkAccessFlags visibleAccess;
+    };
+
+    std::map<VkBuffer, std::vector<Range>> pending;
+
+    // everything a secondary command buffer accesses, ordered as a whole by execute()
+    bool secondary = false;
+    std::map<VkBuffer, std::vector<Range>> footprint;
+    std::vector<std::pair<VkBuffer, Range>> bound;
+    unsigned int barrierCount = 0;
+
+    // scratch of the helpers recording into this command buffer, outgrown buffers are freed by
+    // the next begin() since the recording using them can no longer be pending
+    std::vector<Buffer *> scratchBuffers;
+    std::vector<Buffer *> retired;
+
     void sharedConstructor();
+    static void track(std::map<VkBuffer, std::vector<Range>> &tracked, std::pair<VkBuffer, Range> &use);
+    void synchronize(std::vector<std::pair<VkBuffer, Range>> &uses);
+    std::vector<std::pair<VkBuffer, Range>> boundUses();
+    void pushConstants(const void *data, uint32_t byteSize, uint32_t offset);
+    VkBuffer scratch(unsigned int slot, VkDeviceSize byteSize);
+    void freeScratch(std::vector<Buffer *> &buffers);
 
 public:
-    CommandBuffer(Device &device);
+    // secondary command buffers are recorded once and run from primaries with execute()
+    CommandBuffer(Device &device, bool secondary = false);
     CommandBuffer(Device &device, Program &program, Arguments &arguments);
+    CommandBuffer(const CommandBuffer &commandBuffer) = delete;
+    CommandBuffer(CommandBuffer &&commandBuffer) noexcept;
+    CommandBuffer &operator=(const CommandBuffer &commandBuffer) = delete;
+    CommandBuffer &operator=(CommandBuffer &&commandBuffer) noexcept;
+    ~CommandBuffer();
     void destroy();
     operator VkCommandBuffer();
     void begin();
+    // dynamicOffsets move the windows of BUFFER_DYNAMIC resources, see Arguments::bindTo
+    void bind(Program &program, Arguments &arguments, std::vector<uint32_t> dynamicOffsets = {});
     void barrier();
     void dispatch(int x = 1, int y = 1, int z = 1);
+
+    // workgroup counts from a VkDispatchIndirectCommand in the buffer, offset a multiple of 4
+    void dispatchIndirect(VkBuffer buffer, VkDeviceSize offset = 0);
+    void copy(VkBuffer src, VkBuffer dst, VkDeviceSize byteSize, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
+
+    // every region in one vkCmdCopyBuffer behind one barrier, regions must not overlap
+    void copy(VkBuffer src, VkBuffer dst, std::vector<VkBufferCopy> regions);
+
+    // runs an ended secondary command buffer, bind again before the next dispatch
+    void execute(CommandBuffer &secondary);
+    unsigned int getBarrierCount();
+
+    template <class T>
+    void pushConstants(const T &constants, uint32_t offset = 0)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "push constants must be trivially copyable");
+        static_assert(sizeof(T) % 4 == 0, "push constants must be a multiple of 4 bytes");
+        pushConstants(&constants, sizeof(T), offset);
+    }
+
     void end();
+
+    // timestamps around scopes and dispatches, off unless enabled
+    void enableProfiling(uint32_t maxMarkers = 4096);
+    void beginScope(const char *name);
+    void endScope();
+    void collectProfile();
+    std::vector<ProfileEntry> getProfile();
+    void exportChromeTrace(std::ostream &out);
 };
 
 }
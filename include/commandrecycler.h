@@ -0,0 +1,38 @@
+#ifndef COMMANDRECYCLER_H
+#define COMMANDRECYCLER_H
+
+#include "device.h"
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace vc {
+
+// one command pool per recording thread so that threads never share a pool. Command
+// buffers return to the pool of the thread that acquired them once their submission
+// completed, and are handed out again from there. Pools of finished threads stay until destroy()
+class CommandRecycler : protected Device {
+private:
+    struct Pool {
+        VkCommandPool commandPool;
+        std::vector<VkCommandBuffer> free;
+        std::vector<std::pair<VkCommandBuffer, Completion>> inFlight;
+    };
+
+    // guards the map only, each pool is used by its own thread alone
+    std::mutex mutex;
+    std::map<std::thread::id, Pool *> pools;
+
+    Pool &threadPool();
+
+public:
+    CommandRecycler(Device &device);
+    VkCommandBuffer acquire();
+    void release(VkCommandBuffer commandBuffer, Completion completion);
+    void destroy();
+};
+
+}
+
+#endif // COMMANDRECYCLER_H
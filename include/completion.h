@@ -0,0 +1,37 @@
+#ifndef COMPLETION_H
+#define COMPLETION_H
+
+#include <vulkan/vulkan.h>
+#include <functional>
+
+namespace vc {
+
+class FencePool;
+
+// a value of a timeline semaphore, submissions can wait for it on the device
+struct SyncPoint {
+    VkSemaphore semaphore;
+    uint64_t value;
+};
+
+// lightweight handle to a submission, backed by a recycled fence of the device's FencePool.
+// A default constructed Completion is already complete
+class Completion {
+private:
+    FencePool *fencePool = nullptr;
+    void *record = nullptr;
+    uint64_t generation = 0;
+
+public:
+    Completion();
+    Completion(FencePool *fencePool, void *record, uint64_t generation);
+    bool poll();
+    bool wait(uint64_t timeout = UINT64_MAX);
+
+    // on the device's completion thread once done, in the order callbacks were registered
+    void then(std::function<void()> callback);
+};
+
+}
+
+#endif // COMPLETION_H
@@ -14,8 +14,18 @@ enum Error{
     ERROR_COMMAND
 };
 
+// a dynamic buffer is bound as a window whose offset is given each time it is bound, so
+// one set of arguments serves every slice of a larger buffer
 enum ResourceType {
-    BUFFER = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+    BUFFER = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+    BUFFER_DYNAMIC = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC
+};
+
+// how a program uses each of its resources, for hazard tracking
+enum Access {
+    READ = 1,
+    WRITE = 2,
+    READ_WRITE = READ | WRITE
 };
 
 }
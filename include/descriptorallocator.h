@@ -0,0 +1,51 @@
+#ifndef DESCRIPTORALLOCATOR_H
+#define DESCRIPTORALLOCATOR_H
+
+#include "device.h"
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+
+namespace vc {
+
+// hands out descriptor sets from pools grown a page at a time and caches them by
+// (layout, bound buffer ranges and their types). Sets are freed when a buffer they point at
+// or their layout is destroyed, reset() recycles every pool at once
+class DescriptorAllocator : protected Device {
+private:
+    typedef std::vector<uint64_t> Key;
+
+    struct Entry {
+        VkDescriptorSet descriptorSet;
+        size_t pool;
+    };
+
+    std::mutex mutex;
+    std::vector<VkDescriptorPool> pools;
+    size_t currentPool = 0;
+
+    // bumped by every reset(), sets of an older generation are gone
+    std::atomic<uint64_t> generation;
+    std::map<Key, Entry> cache;
+    std::map<VkBuffer, std::vector<Key>> buffers;
+
+    VkDescriptorSet allocate(VkDescriptorSetLayout descriptorSetLayout);
+    void release(std::map<Key, Entry>::iterator cached);
+
+public:
+    DescriptorAllocator(Device &device);
+    VkDescriptorSet get(VkDescriptorSetLayout descriptorSetLayout, std::vector<VkDescriptorBufferInfo> &bufferInfos,
+                        std::vector<ResourceType> &resourceTypes);
+    void evict(VkBuffer buffer);
+
+    // frees the sets of a layout about to be destroyed
+    void evictLayout(VkDescriptorSetLayout descriptorSetLayout);
+    void reset();
+    uint64_t getGeneration();
+    void destroy();
+};
+
+}
+
+#endif // DESCRIPTORALLOCATOR_H
@@ -3,30 +3,102 @@
 
 #include <vulkan/vulkan.h>
 #include "constants.h"
+#include "completion.h"
+#include <vector>
 
 namespace vc {
 
-class CommandBuffer;
+class CommandRecycler;
+class StagingRing;
+class FencePool;
+class Allocator;
+class QueueSync;
+class PipelineCache;
+class DescriptorAllocator;
+
+// everything a logical device shares with the objects created on it. It lives on the heap
+// once per device, so Device and everything built on it only carry a pointer
+struct DeviceContext {
+    enum {
+        MAX_COMPUTE_QUEUES = 4
+    };
 
-class Device {
-protected:
     VkPhysicalDevice physicalDevice;
     VkPhysicalDeviceProperties physicalDeviceProperties;
-    VkDevice device;
     VkQueue queue;
-    CommandBuffer *implicitCommandBuffer;
+    VkQueue computeQueues[MAX_COMPUTE_QUEUES];
+    VkQueue transferQueue;
+    unsigned int numComputeQueues = 0;
+    CommandRecycler *commandRecycler = nullptr;
+    StagingRing *stagingRing = nullptr;
+    FencePool *fencePool = nullptr;
+    Allocator *allocator = nullptr;
+    QueueSync *queueSync = nullptr;
+    PipelineCache *pipelineCache = nullptr;
+    DescriptorAllocator *descriptorAllocator = nullptr;
+    PFN_vkGetMemoryHostPointerPropertiesEXT getMemoryHostPointerProperties = nullptr;
+
+    // VK_KHR_timeline_semaphore, null without it
+    PFN_vkWaitSemaphores timelineWait = nullptr;
+    PFN_vkSignalSemaphore timelineSignal = nullptr;
+    PFN_vkGetSemaphoreCounterValue timelineValue = nullptr;
+    bool unifiedMemory = false;
+    bool float64 = false;
+
+    // zero unless the device is 1.1 and created through an instance that is too
+    uint32_t subgroupSize = 0;
+    VkShaderStageFlags subgroupStages = 0;
+    VkSubgroupFeatureFlags subgroupOperations = 0;
 
     int memoryTypeMappable = -1,
         memoryTypeLocal = -1,
-        computeQueueFamily = -1;
+        computeQueueFamily = -1,
+        transferQueueFamily = -1;
+};
+
+// a handle to a logical device, copies refer to the same device. Objects created on a
+// device have to be destroyed (or go out of scope) before destroy() is called
+class Device {
+public:
+    enum {
+        MAX_COMPUTE_QUEUES = DeviceContext::MAX_COMPUTE_QUEUES
+    };
+
+protected:
+    DeviceContext *context;
+    VkDevice device;
 
 public:
-    Device(VkPhysicalDevice physicalDevice);
+    Device(VkPhysicalDevice physicalDevice, const char *pipelineCacheDirectory = nullptr, VkInstance instance = VK_NULL_HANDLE);
     void destroy();
-    void submit(VkCommandBuffer commandBuffer);
+    // thread-safe, submissions arriving from several threads meanwhile go out in one vkQueueSubmit
+    Completion submit(VkCommandBuffer commandBuffer, unsigned int queueIndex = 0);
+
+    // one vkQueueSubmit for all of them, run in order
+    Completion submit(std::vector<VkCommandBuffer> commandBuffers, unsigned int queueIndex = 0);
+
+    // a begun command buffer from the calling thread's own pool. submitAcquired() on the same
+    // thread ends and submits it, it is recycled once the submission completed
+    VkCommandBuffer acquireCommandBuffer();
+    Completion submitAcquired(VkCommandBuffer commandBuffer, unsigned int queueIndex = 0);
+
+    // starts once every point in after is reached, without a host round-trip. The returned
+    // point on the queue's timeline is reached when the submission completes
+    SyncPoint enqueue(VkCommandBuffer commandBuffer, std::vector<SyncPoint> after = {}, unsigned int queueIndex = 0);
+    bool wait(SyncPoint point, uint64_t timeout = UINT64_MAX);
+    bool hasTimelineSemaphores();
+    bool hasUnifiedMemory();
+    bool canImportHostMemory();
+    bool hasFloat64();
+    bool hasSubgroupArithmetic();
+    uint32_t getSubgroupSize();
+    unsigned int getComputeQueueCount();
     void wait();
+    void savePipelineCache();
+    void resetDescriptorSets();
     const char *getName();
     uint32_t getVendorId();
+    const VkPhysicalDeviceProperties &getProperties();
 };
 
 }
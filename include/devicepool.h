@@ -3,16 +3,60 @@
 
 #include "device.h"
 #include <vector>
+#include <string>
+#include <mutex>
 
 namespace vc {
 
+// what enumeration tells about a device without creating it
+struct PhysicalDeviceInfo {
+    VkPhysicalDevice physicalDevice;
+    VkPhysicalDeviceProperties properties;
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    std::vector<VkQueueFamilyProperties> queueFamilies;
+    VkDeviceSize deviceLocalMemory;
+};
+
+// every field left zero or empty matches any device. An aggregate, so start from
+// DeviceFilter filter = {} or brace-initialize it in field order
+struct DeviceFilter {
+    uint32_t vendorId;
+    std::vector<VkPhysicalDeviceType> deviceTypes;
+
+    // flags one queue family has to have all of, and whether a transfer-only family is needed
+    VkQueueFlags queueFlags;
+    bool dedicatedTransfer;
+    VkDeviceSize minDeviceLocalMemory;
+    uint32_t minApiVersion;
+};
+
+// enumerates physical devices when constructed, logical devices are only created once
+// asked for and then in parallel, one thread per device. Created devices are shared by
+// every later call and destroyed by the caller like before
 class DevicePool {
 private:
     VkInstance instance;
+    uint32_t apiVersion;
+    std::string pipelineCacheDirectory;
+    bool hasPipelineCacheDirectory;
+    std::vector<PhysicalDeviceInfo> physicalDevices;
+
+    std::mutex mutex;
+    std::vector<Device *> logicalDevices;
     std::vector<Device> devices;
 
+    void create(std::vector<unsigned int> indices);
+
 public:
-    DevicePool();
+    DevicePool(const char *pipelineCacheDirectory = nullptr);
+    const std::vector<PhysicalDeviceInfo> &getPhysicalDevices();
+
+    // indices into getPhysicalDevices() in enumeration order
+    std::vector<unsigned int> select(DeviceFilter filter);
+    Device &getDevice(unsigned int index);
+    std::vector<Device> getDevices(DeviceFilter filter);
+
+    // all of them, in enumeration order
     std::vector<Device> &getDevices();
     VkInstance &getInstance();
 };
@@ -20,4 +64,3 @@ public:
 }
 
 #endif // DEVICEPOOL_H
-
@@ -0,0 +1,55 @@
+#ifndef FENCEPOOL_H
+#define FENCEPOOL_H
+
+#include "device.h"
+#include "completion.h"
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+namespace vc {
+
+// every vkQueueSubmit of the library goes through submit(), its mutex is what keeps two
+// threads from using one queue at the same time
+class FencePool : protected Device {
+private:
+    struct Record {
+        VkFence fence;
+        uint64_t generation;
+        unsigned int waiters;
+    };
+
+    struct Callback {
+        Record *record;
+        uint64_t generation;
+        std::function<void()> function;
+    };
+
+    std::mutex mutex;
+    std::vector<Record *> records, freeRecords;
+    std::deque<Record *> inFlight;
+
+    // completion thread, started on first use of Completion::then
+    std::thread completionThread;
+    std::condition_variable condition;
+    std::deque<Callback> callbacks;
+    bool running = false;
+
+    Record *acquire();
+    void recycle();
+    void completionLoop();
+
+public:
+    FencePool(Device &device);
+    Completion submit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo *submitInfos);
+    bool poll(void *record, uint64_t generation);
+    bool wait(void *record, uint64_t generation, uint64_t timeout);
+    void then(void *record, uint64_t generation, std::function<void()> callback);
+    void destroy();
+};
+
+}
+
+#endif // FENCEPOOL_H
@@ -0,0 +1,74 @@
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include "device.h"
+#include "program.h"
+#include "buffer.h"
+#include "commandbuffer.h"
+#include <vector>
+
+namespace vc {
+
+// compared with recording the nodes in declaration order with a barrier after each
+struct GraphReport {
+    unsigned int nodes, levels;
+    unsigned int barriers, barriersRemoved;
+    size_t transientBytes, allocatedBytes, memorySaved;
+};
+
+// dispatches and copies declared once with the buffers they use. Dependencies follow
+// from declaration order and each program's access, nodes without dependencies between
+// them share a level and levels are separated by one barrier. Transient buffers whose
+// levels don't overlap share memory. Programs must outlive compile()
+class Graph : protected Device {
+private:
+    struct Resource {
+        VkBuffer buffer;
+        size_t byteSize;
+        bool transient;
+        int firstLevel, lastLevel;
+        unsigned int slot;
+    };
+
+    struct Node {
+        Program *program;
+        std::vector<unsigned int> buffers;
+        int x, y, z;
+        size_t byteSize, srcOffset, dstOffset;
+        unsigned int level;
+    };
+
+    std::vector<Resource> resources;
+    std::vector<Node> nodes;
+    std::vector<Buffer> slots;
+    unsigned int numLevels = 0;
+    CommandBuffer *commandBuffer = nullptr;
+    GraphReport report = {};
+
+    unsigned int addNode(Node node, std::vector<Access> access);
+    void alias();
+
+public:
+    Graph(Device &device);
+    Graph(const Graph &graph) = delete;
+    Graph &operator=(const Graph &graph) = delete;
+    ~Graph();
+
+    // handles to buffers, transient ones are only valid within the graph
+    unsigned int buffer(size_t byteSize);
+    unsigned int import(Buffer &buffer);
+
+    unsigned int dispatch(Program &program, std::vector<unsigned int> buffers, int x = 1, int y = 1, int z = 1);
+    // the ranges must lie within the declared buffer sizes
+    unsigned int copy(unsigned int src, unsigned int dst, size_t byteSize, size_t srcOffset = 0, size_t dstOffset = 0);
+
+    // records the graph once, after which it is replayed with submit
+    void compile();
+    Completion submit(unsigned int queueIndex = 0);
+    GraphReport getReport();
+    void destroy();
+};
+
+}
+
+#endif // GRAPH_H
@@ -0,0 +1,24 @@
+#ifndef GROUPCOUNT_H
+#define GROUPCOUNT_H
+
+#include "program.h"
+#include "commandbuffer.h"
+
+namespace vc {
+
+// built-in kernel turning a uint32_t element count in a buffer into a VkDispatchIndirectCommand
+// of ceil(count / localSize) x 1 x 1 workgroups, clamped to the device limit, so that
+// variable-size stages can follow each other with dispatchIndirect and no host round-trip
+class GroupCount : protected Program {
+public:
+    GroupCount(Device &device);
+
+    // leaves its own program bound, bind the next stage's program afterwards
+    void enqueue(CommandBuffer &commandBuffer, VkBuffer count, VkDeviceSize countOffset,
+                 VkBuffer groups, VkDeviceSize groupsOffset, uint32_t localSize);
+    using Program::destroy;
+};
+
+}
+
+#endif // GROUPCOUNT_H
@@ -0,0 +1,27 @@
+#ifndef PIPELINECACHE_H
+#define PIPELINECACHE_H
+
+#include "device.h"
+#include <string>
+
+namespace vc {
+
+// device scoped VkPipelineCache shared by all programs, persisted to a file named
+// after the vendor, device and pipeline cache UUID when a directory is given
+class PipelineCache : protected Device {
+private:
+    VkPipelineCache pipelineCache;
+    std::string fileName;
+
+    bool validate(const char *data, size_t byteLength);
+
+public:
+    PipelineCache(Device &device, const char *directory = nullptr);
+    operator VkPipelineCache();
+    void save();
+    void destroy();
+};
+
+}
+
+#endif // PIPELINECACHE_H
@@ -0,0 +1,68 @@
+#ifndef PRIMITIVES_H
+#define PRIMITIVES_H
+
+#include "program.h"
+#include "buffer.h"
+#include "commandbuffer.h"
+#include <string>
+#include <vector>
+#include <map>
+
+namespace vc {
+
+enum ElementType {
+    U32,
+    I32,
+    F32,
+    F64
+};
+
+// reduce, scan, compaction and radix sort recorded into a command buffer, which must be
+// recording. Kernels are loaded from shaderDirectory (built by make shaders) the first time
+// they are used, in their subgroup variant where the device has compute subgroup arithmetic.
+// Everything is multi-pass over tiles of 1024 elements (2048 for reduce), passes are ordered
+// by the command buffer's hazard tracking. Scratch buffers belong to the command buffer, so
+// recordings into different command buffers may be in flight at once
+class Primitives : protected Device {
+private:
+    std::string shaderDirectory;
+    bool subgroups;
+    std::map<std::string, Program *> programs;
+
+    // slots of the command buffer's scratch, scans take two per level
+    enum {
+        SCRATCH_REDUCE = 0,
+        SCRATCH_COMPACT = 2,
+        SCRATCH_SORT = 3,
+        SCRATCH_SCAN = 8
+    };
+
+    struct Parameters {
+        uint32_t count, shift, numGroups, inclusive;
+    };
+
+    Program &program(const char *kernel, ElementType type);
+    void dispatch(CommandBuffer &commands, Program &program, std::vector<BufferView> buffers, Parameters parameters, uint32_t groups);
+    void scan(CommandBuffer &commands, ElementType type, VkBuffer input, VkBuffer output, uint32_t count, bool inclusive, unsigned int level);
+
+public:
+    Primitives(Device &device, const char *shaderDirectory = "shaders/primitives");
+    static size_t elementSize(ElementType type);
+
+    // the sum of count elements into the first element of result
+    void reduce(CommandBuffer &commands, ElementType type, VkBuffer input, VkBuffer result, uint32_t count);
+    void scan(CommandBuffer &commands, ElementType type, VkBuffer input, VkBuffer output, uint32_t count, bool inclusive = true);
+
+    // keeps the elements whose uint32_t flag is 1 (flags are 0 or 1), in order. The number
+    // kept is written as a uint32_t to survivors, ready for GroupCount
+    void compact(CommandBuffer &commands, ElementType type, VkBuffer input, VkBuffer flags,
+                 VkBuffer output, VkBuffer survivors, uint32_t count);
+
+    // stable ascending sort of keys of the given type, carrying a uint32_t value each
+    void sort(CommandBuffer &commands, ElementType keyType, VkBuffer keys, VkBuffer values, uint32_t count);
+    void destroy();
+};
+
+}
+
+#endif // PRIMITIVES_H
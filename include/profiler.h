@@ -0,0 +1,69 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "device.h"
+#include <vector>
+#include <string>
+#include <map>
+#include <ostream>
+
+namespace vc {
+
+// GPU time per scope or dispatch in microseconds, over every collected execution. Dispatches
+// are numbered in recording order, "scope/dispatch 3" is the fourth dispatch of the recording
+struct ProfileEntry {
+    std::string name;
+    uint64_t count;
+    double min, avg, max;
+};
+
+// timestamp queries written around scopes and dispatches of one command buffer
+class Profiler : protected Device {
+private:
+    struct Marker {
+        std::string name;
+        uint32_t query;
+    };
+
+    struct Statistics {
+        uint64_t count = 0;
+        double min = 0, max = 0, total = 0;
+    };
+
+    struct Event {
+        std::string name;
+        double start, duration;
+    };
+
+    VkQueryPool queryPool;
+    uint32_t capacity, used = 0;
+    bool needsReset = true;
+    uint64_t validMask;
+    std::vector<Marker> markers;
+    std::vector<Marker> scopes;
+    uint32_t dispatchQuery = ~0U, dispatches = 0;
+
+    // entries in the order they were first collected
+    std::vector<std::pair<std::string, Statistics>> statistics;
+    std::map<std::string, size_t> statisticsIndex;
+    std::vector<Event> events;
+
+    uint32_t write(VkCommandBuffer commandBuffer, VkPipelineStageFlags stage, const std::string &name);
+
+public:
+    Profiler(Device &device, uint32_t maxMarkers);
+    void restart();
+    void beginScope(VkCommandBuffer commandBuffer, const char *name);
+    void endScope(VkCommandBuffer commandBuffer);
+    void beginDispatch(VkCommandBuffer commandBuffer);
+    void endDispatch(VkCommandBuffer commandBuffer);
+    void end();
+    void collect();
+    std::vector<ProfileEntry> report();
+    void exportChromeTrace(std::ostream &out);
+    void destroy();
+};
+
+}
+
+#endif // PROFILER_H
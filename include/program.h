@@ -3,20 +3,93 @@
 
 #include "device.h"
 #include <fstream>
+#include <cstring>
 #include <vector>
+#include <map>
+#include <mutex>
 
 namespace vc {
 
+// a 32-bit specialization constant, the workgroup size is specialized by declaring
+// local_size_x_id/local_size_y_id/local_size_z_id in the shader and setting those ids
+struct SpecializationConstant {
+    uint32_t id;
+    uint32_t value;
+
+    SpecializationConstant(uint32_t id, uint32_t value) : id(id), value(value) {}
+    SpecializationConstant(uint32_t id, int32_t value) : id(id), value(value) {}
+    SpecializationConstant(uint32_t id, float value) : id(id) {
+        memcpy(&this->value, &value, sizeof(float));
+    }
+};
+
 class Program : protected Device {
+    friend class Arguments;
+    friend class CommandBuffer;
+    friend class Graph;
+    friend class StreamExecutor;
+
+private:
+    // pipelines built from the shader module, keyed by their sorted (id, value) pairs. Shared
+    // by the program and its specializations, the last one destroyed frees everything
+    struct Variants {
+        std::mutex mutex;
+        std::map<std::vector<uint32_t>, VkPipeline> pipelines;
+        unsigned int references;
+    };
+
+    Variants *variants;
+    Program(const Program &program) = default;
+    static std::vector<uint32_t> readFile(const char *fileName);
+    void sharedConstructor(const uint32_t *code, size_t byteSize, std::vector<ResourceType> *declaredResourceTypes,
+                           std::vector<SpecializationConstant> &specializationConstants);
+    VkPipeline createPipeline(std::vector<SpecializationConstant> &specializationConstants);
+
 protected:
     VkShaderModule shaderModule;
     VkPipelineLayout pipelineLayout;
     VkDescriptorSetLayout descriptorSetLayout;
     VkPipeline pipeline;
+    uint32_t pushConstantSize;
+    std::vector<ResourceType> resourceTypes;
+    std::vector<Access> access;
+    uint32_t localSize[3];
 
 public:
-    Program(Device &device, const char *fileName, std::vector<ResourceType> resourceTypes);
+    Program(Device &device, const char *fileName, std::vector<ResourceType> resourceTypes,
+            std::vector<SpecializationConstant> specializationConstants = {}, uint32_t pushConstantSize = 0);
+
+    // from SPIR-V already in memory, byteSize is in bytes
+    Program(Device &device, const uint32_t *code, size_t byteSize, std::vector<ResourceType> resourceTypes,
+            std::vector<SpecializationConstant> specializationConstants = {}, uint32_t pushConstantSize = 0);
+
+    // resources, their access and the push constant size reflected from the shader. Given
+    // resources or push constants that don't match what the shader declares throw ERROR_SHADER,
+    // except that any buffer may be given as BUFFER_DYNAMIC
+    Program(Device &device, const char *fileName);
+    Program(Device &device, const uint32_t *code, size_t byteSize);
+
+    // e.g. an array from make embed
+    template <size_t N>
+    Program(Device &device, const uint32_t (&code)[N]) : Program(device, code, sizeof(code))
+    {
+
+    }
+
+    Program(Program &&program) noexcept;
+    Program &operator=(Program &&program) noexcept;
+    Program &operator=(const Program &program) = delete;
+    ~Program();
+
+    Program specialize(std::vector<SpecializationConstant> specializationConstants);
     void bindTo(VkCommandBuffer commandBuffer);
+
+    // one per resource, READ_WRITE unless declared otherwise
+    void setAccess(std::vector<Access> access);
+
+    // as compiled, before specialization
+    uint32_t getLocalSize(unsigned int dimension = 0);
+    void destroy();
 };
 
 }
@@ -0,0 +1,59 @@
+#ifndef QUEUESYNC_H
+#define QUEUESYNC_H
+
+#include "device.h"
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+namespace vc {
+
+// orders work between the transfer queue and the compute queues with binary semaphores.
+// Transfers are waited on by the next submission of every other compute queue, and with
+// afterCompute wait for everything submitted to the compute queues before them. Buffer
+// uploads and downloads always pass it, only callers that know the buffers they touch are
+// idle (the stream executor, for slots it has retired) skip the wait.
+// With timeline semaphores every compute submission also signals the next value of its
+// queue's timeline and may wait on points of other timelines
+class QueueSync : protected Device {
+private:
+    struct Signal {
+        VkSemaphore semaphore;
+        Completion completion;
+    };
+
+    std::mutex mutex;
+    std::vector<VkSemaphore> freeSemaphores;
+    std::vector<Signal> usedSemaphores;
+    std::vector<Signal> pendingWaits[MAX_COMPUTE_QUEUES];
+    bool dirty[MAX_COMPUTE_QUEUES] = {};
+    VkSemaphore timelines[MAX_COMPUTE_QUEUES] = {};
+    uint64_t timelineValues[MAX_COMPUTE_QUEUES] = {};
+
+    // submissions waiting for the one in progress on their queue to return
+    struct BatchEntry {
+        const std::vector<VkCommandBuffer> *commandBuffers;
+        Completion completion;
+        bool done, failed;
+    };
+
+    std::mutex batchMutex;
+    std::condition_variable batchCondition;
+    std::vector<BatchEntry *> batches[MAX_COMPUTE_QUEUES];
+    bool submitting[MAX_COMPUTE_QUEUES] = {};
+
+    bool linked(unsigned int queueIndex);
+    VkSemaphore acquire();
+
+public:
+    QueueSync(Device &device);
+    Completion computeSubmit(unsigned int queueIndex, VkSubmitInfo submitInfo,
+                             const std::vector<SyncPoint> &after = {}, SyncPoint *point = nullptr);
+    Completion batchSubmit(unsigned int queueIndex, const std::vector<VkCommandBuffer> &commandBuffers);
+    Completion transferSubmit(VkSubmitInfo submitInfo, bool afterCompute);
+    void destroy();
+};
+
+}
+
+#endif // QUEUESYNC_H
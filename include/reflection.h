@@ -0,0 +1,28 @@
+#ifndef REFLECTION_H
+#define REFLECTION_H
+
+#include "constants.h"
+#include <vector>
+
+namespace vc {
+
+// the layout a compute shader declares, read from its SPIR-V. Resources are the storage
+// buffers of descriptor set 0, which have to be bound at 0, 1, 2... like Program expects.
+// Anything else the library can't bind is rejected with ERROR_SHADER
+struct Reflection {
+    std::vector<ResourceType> resourceTypes;
+
+    // READ for readonly, WRITE for writeonly buffers
+    std::vector<Access> access;
+    uint32_t pushConstantSize;
+
+    // as compiled, localSizeIds holds the specialization constant id of a dimension or -1
+    uint32_t localSize[3];
+    int localSizeIds[3];
+
+    Reflection(const uint32_t *code, size_t byteSize);
+};
+
+}
+
+#endif // REFLECTION_H
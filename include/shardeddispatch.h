@@ -0,0 +1,61 @@
+#ifndef SHARDEDDISPATCH_H
+#define SHARDEDDISPATCH_H
+
+#include "devicepool.h"
+#include "program.h"
+#include <vector>
+
+namespace vc {
+
+// host memory split along with the global range, one slice is one element of a
+// 1D range or one row of a 2D range. Inputs are uploaded to and outputs gathered
+// from every shard
+struct ShardedBuffer {
+    void *hostPtr;
+    size_t bytesPerSlice;
+    bool input, output;
+};
+
+// the first workgroup of a shard within the whole range, pushed as the program's push
+// constants. Shaders declaring layout(push_constant) uniform Shard { uvec2 firstGroup; }
+// index globally with firstGroup * gl_WorkGroupSize.xy + gl_GlobalInvocationID.xy
+struct FirstGroup {
+    uint32_t x, y;
+};
+
+// runs the same program on every device of a pool (optionally split further into logical
+// shards per device) with the global range divided according to per shard weights.
+// Shards see gl_GlobalInvocationID and their buffers relative to their own part of the range,
+// FirstGroup tells them where that part starts
+class ShardedDispatch {
+private:
+    struct Shard {
+        Device device;
+        Program *program;
+        unsigned int queueIndex;
+        double weight;
+    };
+
+    struct Range {
+        size_t offset, slices, groups;
+    };
+
+    std::vector<Program *> programs;
+    std::vector<Shard> shards;
+
+    std::vector<Range> split(size_t slices, size_t granularity);
+    std::vector<double> run(size_t globalX, size_t globalY, std::vector<ShardedBuffer> &buffers, int localX, int localY);
+
+public:
+    ShardedDispatch(DevicePool &devicePool, const char *fileName, std::vector<ResourceType> resourceTypes, unsigned int shardsPerDevice = 1);
+    void weighByProperties();
+    void calibrate(size_t globalX, size_t globalY, std::vector<ShardedBuffer> buffers, int localX = 1, int localY = 1);
+    void dispatch(size_t globalX, size_t globalY, std::vector<ShardedBuffer> buffers, int localX = 1, int localY = 1);
+    std::vector<double> getWeights();
+    size_t getShardCount();
+    void destroy();
+};
+
+}
+
+#endif // SHARDEDDISPATCH_H
@@ -0,0 +1,45 @@
+#ifndef STAGINGRING_H
+#define STAGINGRING_H
+
+#include "device.h"
+#include <vector>
+#include <mutex>
+
+namespace vc {
+
+class Buffer;
+
+// persistently mapped host memory split in equally sized slots, each slot
+// owning a command buffer and the completion of its last transfer so that
+// several transfers can be in flight. Transfers from several threads take turns
+class StagingRing : protected Device {
+private:
+    struct Slot {
+        VkCommandBuffer commandBuffer;
+        Completion completion;
+    };
+
+    std::mutex mutex;
+    VkCommandPool commandPool;
+    Buffer *stagingBuffer;
+    char *mapped;
+    size_t slotSize;
+    std::vector<Slot> slots;
+    unsigned int nextSlot = 0;
+    VkAccessFlags shaderAccess;
+
+    unsigned int acquire();
+    void begin(unsigned int slot);
+    void end(unsigned int slot);
+
+public:
+    StagingRing(Device &device, size_t slotSize = 4 << 20, unsigned int numSlots = 8);
+    void upload(VkBuffer dst, const void *hostPtr, size_t byteSize, size_t offset);
+    void download(VkBuffer src, void *hostPtr, size_t byteSize, size_t offset);
+    void synchronizeHost();
+    void destroy();
+};
+
+}
+
+#endif // STAGINGRING_H
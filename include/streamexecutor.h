@@ -0,0 +1,58 @@
+#ifndef STREAMEXECUTOR_H
+#define STREAMEXECUTOR_H
+
+#include "device.h"
+#include "program.h"
+#include "buffer.h"
+#include "arguments.h"
+#include <vector>
+
+namespace vc {
+
+// runs a program over host data larger than device memory, one chunk at a time through a
+// rotating set of device buffers so that uploads, dispatches and downloads of different
+// chunks overlap. The program takes either one buffer it updates in place or an input and
+// an output buffer of the same size, each workgroup covering bytesPerGroup bytes
+class StreamExecutor : protected Device {
+private:
+    struct Slot {
+        Buffer *input = nullptr, *output = nullptr;
+        Buffer *stagingIn = nullptr, *stagingOut = nullptr;
+        Arguments *arguments = nullptr;
+        VkCommandBuffer upload = VK_NULL_HANDLE, compute = VK_NULL_HANDLE, download = VK_NULL_HANDLE;
+        Completion completion;
+        char *destination = nullptr;
+        size_t size = 0;
+    };
+
+    Program &program;
+    size_t chunkSize, bytesPerGroup;
+    std::vector<Slot> slots;
+    VkCommandPool computeCommandPool = VK_NULL_HANDLE, transferCommandPool = VK_NULL_HANDLE;
+    bool splitQueues;
+    double throughput = 0;
+
+    void create();
+    void record(Slot &slot, size_t byteSize);
+    void submit(Slot &slot, unsigned int queueIndex);
+    void retire(Slot &slot);
+
+public:
+    // refers to the program, which has to outlive the executor
+    StreamExecutor(Device &device, Program &program, size_t chunkSize, size_t bytesPerGroup, unsigned int depth = 3);
+    StreamExecutor(const StreamExecutor &streamExecutor) = delete;
+    StreamExecutor &operator=(const StreamExecutor &streamExecutor) = delete;
+
+    // output may be the same memory as input but must not partially overlap it, chunks are
+    // written back while later ones are still to be read. Throws ERROR_MALLOC if outputSize
+    // is smaller than inputSize
+    void run(const void *input, size_t inputSize, void *output, size_t outputSize);
+
+    // bytes per second of the last run
+    double getThroughput();
+    void destroy();
+};
+
+}
+
+#endif // STREAMEXECUTOR_H
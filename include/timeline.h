@@ -0,0 +1,27 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include "device.h"
+
+namespace vc {
+
+// a timeline semaphore owned by the host, e.g. to hold back submissions enqueued after
+// one of its points until the host signals it. Needs Device::hasTimelineSemaphores()
+class Timeline : protected Device {
+private:
+    VkSemaphore semaphore;
+
+public:
+    Timeline(Device &device, uint64_t initialValue = 0);
+    SyncPoint at(uint64_t value);
+    uint64_t getValue();
+    bool wait(uint64_t value, uint64_t timeout = UINT64_MAX);
+
+    // values only ever increase
+    void signal(uint64_t value);
+    void destroy();
+};
+
+}
+
+#endif // TIMELINE_H
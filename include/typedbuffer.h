@@ -0,0 +1,55 @@
+#ifndef TYPEDBUFFER_H
+#define TYPEDBUFFER_H
+
+#include "buffer.h"
+#include <vector>
+#include <type_traits>
+
+namespace vc {
+
+// a buffer of count elements of T, views and transfers are counted in elements
+template <class T>
+class TypedBuffer : public Buffer {
+    static_assert(std::is_trivially_copyable<T>::value, "buffer elements must be trivially copyable");
+
+public:
+    TypedBuffer(Device &device, size_t count, bool mappable = false) : Buffer(device, count * sizeof(T), mappable)
+    {
+
+    }
+
+    using Buffer::upload;
+    using Buffer::download;
+
+    size_t count()
+    {
+        return size() / sizeof(T);
+    }
+
+    // count elements from first, e.g. the window of a BUFFER_DYNAMIC resource
+    BufferView view(size_t first, size_t count)
+    {
+        return Buffer::view(first * sizeof(T), count * sizeof(T));
+    }
+
+    // the dynamic offset that moves a window to element first
+    uint32_t offsetOf(size_t first)
+    {
+        return first * sizeof(T);
+    }
+
+    void upload(const std::vector<T> &elements, size_t first = 0)
+    {
+        Buffer::upload(elements.data(), elements.size() * sizeof(T), first * sizeof(T));
+    }
+
+    // as many elements as elements holds
+    void download(std::vector<T> &elements, size_t first = 0)
+    {
+        Buffer::download(elements.data(), elements.size() * sizeof(T), first * sizeof(T));
+    }
+};
+
+}
+
+#endif // TYPEDBUFFER_H
@@ -8,5 +8,22 @@
 #include "devicepool.h"
 #include "program.h"
 #include "arguments.h"
+#include "stagingring.h"
+#include "completion.h"
+#include "fencepool.h"
+#include "allocator.h"
+#include "queuesync.h"
+#include "shardeddispatch.h"
+#include "pipelinecache.h"
+#include "descriptorallocator.h"
+#include "profiler.h"
+#include "graph.h"
+#include "groupcount.h"
+#include "streamexecutor.h"
+#include "primitives.h"
+#include "timeline.h"
+#include "commandrecycler.h"
+#include "reflection.h"
+#include "typedbuffer.h"
 
 #endif // VC_H
@@ -9,7 +9,23 @@ SOURCES += src/main.cpp \
     src/buffer.cpp \
     src/arguments.cpp \
     src/program.cpp \
-    src/devicepool.cpp
+    src/devicepool.cpp \
+    src/stagingring.cpp \
+    src/completion.cpp \
+    src/fencepool.cpp \
+    src/allocator.cpp \
+    src/queuesync.cpp \
+    src/shardeddispatch.cpp \
+    src/pipelinecache.cpp \
+    src/descriptorallocator.cpp \
+    src/profiler.cpp \
+    src/graph.cpp \
+    src/groupcount.cpp \
+    src/streamexecutor.cpp \
+    src/primitives.cpp \
+    src/timeline.cpp \
+    src/commandrecycler.cpp \
+    src/reflection.cpp
 HEADERS += include/vc.h \
     include/buffer.h \
     include/commandbuffer.h \
@@ -17,8 +33,25 @@ HEADERS += include/vc.h \
     include/device.h \
     include/constants.h \
     include/program.h \
-    include/arguments.h
+    include/arguments.h \
+    include/stagingring.h \
+    include/completion.h \
+    include/fencepool.h \
+    include/allocator.h \
+    include/queuesync.h \
+    include/shardeddispatch.h \
+    include/pipelinecache.h \
+    include/descriptorallocator.h \
+    include/profiler.h \
+    include/graph.h \
+    include/groupcount.h \
+    include/streamexecutor.h \
+    include/primitives.h \
+    include/timeline.h \
+    include/commandrecycler.h \
+    include/reflection.h \
+    include/typedbuffer.h
 
 INCLUDEPATH += include
-LIBS += -L$$_PRO_FILE_PWD_/lib -l:libvulkan.so.1
+LIBS += -L$$_PRO_FILE_PWD_/lib -l:libvulkan.so.1 -lpthread
 QMAKE_CXXFLAGS += -Wno-missing-field-initializers
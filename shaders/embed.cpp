@@ -0,0 +1,57 @@
+// writes a compiled shader as a header holding a constexpr uint32_t array named after
+// the file, e.g. comp.spv becomes comp_spv. Built and run by make embed
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cctype>
+using namespace std;
+
+int main(int argc, char **argv)
+{
+    if (argc != 3) {
+        cerr << "usage: embed shader.spv header.h" << endl;
+        return 1;
+    }
+
+    ifstream fin(argv[1], ifstream::binary | ifstream::ate);
+    if (!fin) {
+        cerr << "cannot read " << argv[1] << endl;
+        return 1;
+    }
+    size_t byteSize = fin.tellg();
+    fin.seekg(0, ifstream::beg);
+    if (byteSize % 4) {
+        cerr << argv[1] << " is not SPIR-V" << endl;
+        return 1;
+    }
+    vector<uint32_t> code(byteSize / 4);
+    fin.read((char *) code.data(), byteSize);
+
+    string name = argv[1];
+    name = name.substr(name.find_last_of('/') + 1);
+    for (char &c : name) {
+        c = isalnum(c) ? c : '_';
+    }
+    string guard = name;
+    for (char &c : guard) {
+        c = toupper(c);
+    }
+
+    ofstream fout(argv[2]);
+    fout << "#ifndef " << guard << "_H" << endl;
+    fout << "#define " << guard << "_H" << endl << endl;
+    fout << "#include <cstdint>" << endl << endl;
+    fout << "// generated from " << argv[1] << " by make embed" << endl;
+    fout << "static constexpr uint32_t " << name << "[] = {";
+    for (size_t i = 0; i < code.size(); i++) {
+        fout << (i % 8 ? " " : "\n    ") << "0x";
+        fout.width(8);
+        fout.fill('0');
+        fout << hex << code[i] << dec << ",";
+    }
+    fout << endl << "};" << endl << endl;
+    fout << "#endif // " << guard << "_H" << endl;
+    return fout ? 0 : 1;
+}
@@ -0,0 +1,82 @@
+// shared by the primitives, compiled once per element type (-DTYPE_u32, -DTYPE_i32,
+// -DTYPE_f32 or -DTYPE_f64) and once more with -DSUBGROUP for devices with subgroup arithmetic
+
+#if defined(TYPE_u32)
+#define T uint
+#elif defined(TYPE_i32)
+#define T int
+#elif defined(TYPE_f32)
+#define T float
+#elif defined(TYPE_f64)
+#define T double
+#endif
+
+#define WORKGROUP_SIZE 256
+
+#ifdef SUBGROUP
+#extension GL_KHR_shader_subgroup_arithmetic : require
+
+// drivers may run compute shaders with smaller subgroups than they report, so there is room
+// for a partial per invocation and the first subgroup scans them in as many steps as it takes
+shared T partials[WORKGROUP_SIZE];
+
+T workgroupInclusiveAdd(T value, out T total)
+{
+	T inclusive = subgroupInclusiveAdd(value);
+	if (gl_SubgroupInvocationID == gl_SubgroupSize - 1) {
+		partials[gl_SubgroupID] = inclusive;
+	}
+	barrier();
+
+	if (gl_SubgroupID == 0) {
+		T carry = T(0);
+		for (uint first = 0; first < gl_NumSubgroups; first += gl_SubgroupSize) {
+			uint id = first + gl_SubgroupInvocationID;
+			T partial = id < gl_NumSubgroups ? partials[id] : T(0);
+			T scanned = subgroupInclusiveAdd(partial) + carry;
+			carry += subgroupAdd(partial);
+			if (id < gl_NumSubgroups) {
+				partials[id] = scanned;
+			}
+		}
+	}
+	barrier();
+
+	if (gl_SubgroupID > 0) {
+		inclusive += partials[gl_SubgroupID - 1];
+	}
+	total = partials[gl_NumSubgroups - 1];
+	barrier();
+	return inclusive;
+}
+#else
+shared T partials[WORKGROUP_SIZE];
+
+// Hillis-Steele over shared memory
+T workgroupInclusiveAdd(T value, out T total)
+{
+	uint id = gl_LocalInvocationID.x;
+	partials[id] = value;
+	barrier();
+
+	for (uint offset = 1; offset < WORKGROUP_SIZE; offset <<= 1) {
+		T other = id >= offset ? partials[id - offset] : T(0);
+		barrier();
+		partials[id] += other;
+		barrier();
+	}
+
+	T inclusive = partials[id];
+	total = partials[WORKGROUP_SIZE - 1];
+	barrier();
+	return inclusive;
+}
+#endif
+
+layout (push_constant) uniform Parameters
+{
+	uint count;
+	uint shift;
+	uint numGroups;
+	uint inclusive;
+};
@@ -0,0 +1,37 @@
+// keys are read as 32-bit words with their bits flipped such that unsigned order
+// matches the order of the key type, 64-bit keys are two little endian words
+
+#define RADIX_BITS 4
+#define RADIX 16
+#define ITEMS 4
+
+#if defined(TYPE_f64)
+#define KEY_WORDS 2
+#else
+#define KEY_WORDS 1
+#endif
+
+// the word of a key holding the sign, flipped
+uint sortableHigh(uint high)
+{
+#if defined(TYPE_i32)
+	return high ^ 0x80000000u;
+#elif defined(TYPE_f32) || defined(TYPE_f64)
+	// negative floats order reversed and before all positive ones
+	return (high & 0x80000000u) != 0 ? ~high : high | 0x80000000u;
+#else
+	return high;
+#endif
+}
+
+// the digit at bit position shift of key index
+uint digitOf(uint index)
+{
+#if KEY_WORDS == 2
+	uint high = keysIn[2 * index + 1];
+	uint sortable = shift >= 32 ? sortableHigh(high) : ((high & 0x80000000u) != 0 ? ~keysIn[2 * index] : keysIn[2 * index]);
+	return (sortable >> (shift & 31)) & (RADIX - 1);
+#else
+	return (sortableHigh(keysIn[index]) >> shift) & (RADIX - 1);
+#endif
+}
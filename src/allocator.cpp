@@ -0,0 +1,127 @@
+#include "allocator.h"
+#include <algorithm>
+
+namespace vc {
+
+// smallest size class is 256 bytes, classes above blockSize / 4 get their own memory
+static const int MIN_CLASS_SHIFT = 8;
+static const VkDeviceSize CHUNK_SIZE = 1 << 20;
+
+Allocator::Allocator(Device &device, VkDeviceSize blockSize) : Device(device), blockSize(blockSize)
+{
+    vkGetPhysicalDeviceMemoryProperties(context->physicalDevice, &memoryProperties);
+}
+
+VkDeviceMemory Allocator::allocateMemory(uint32_t memoryType, VkDeviceSize size, char **mapped)
+{
+    VkMemoryAllocateInfo memoryAllocateInfo = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    memoryAllocateInfo.allocationSize = size;
+    memoryAllocateInfo.memoryTypeIndex = memoryType;
+
+    VkDeviceMemory memory;
+    if (VK_SUCCESS != vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &memory)) {
+        throw ERROR_MALLOC;
+    }
+
+    // host visible memory stays mapped for its whole lifetime
+    *mapped = nullptr;
+    if (memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        if (VK_SUCCESS != vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, (void **) mapped)) {
+            vkFreeMemory(device, memory, nullptr);
+            throw ERROR_MAP;
+        }
+    }
+    return memory;
+}
+
+void Allocator::carve(uint32_t memoryType, int sizeClass)
+{
+    VkDeviceSize classSize = VkDeviceSize(1) << sizeClass;
+    VkDeviceSize chunkSize = std::max(classSize, std::min(CHUNK_SIZE, blockSize));
+
+    // bump allocate a chunk aligned to its class size from the last block
+    std::vector<Block> &typeBlocks = blocks[memoryType];
+    VkDeviceSize offset = 0;
+    if (typeBlocks.size()) {
+        offset = ((typeBlocks.back().used + classSize - 1) / classSize) * classSize;
+    }
+
+    if (typeBlocks.empty() || offset + chunkSize > typeBlocks.back().size) {
+        Block block = {VK_NULL_HANDLE, blockSize, 0, nullptr};
+        block.memory = allocateMemory(memoryType, block.size, &block.mapped);
+        typeBlocks.push_back(block);
+        offset = 0;
+    }
+
+    Block &block = typeBlocks.back();
+    block.used = offset + chunkSize;
+
+    std::vector<Allocation> &freeList = freeLists[std::make_pair(memoryType, sizeClass)];
+    for (VkDeviceSize slot = offset + chunkSize; slot > offset; ) {
+        slot -= classSize;
+
+        Allocation allocation;
+        allocation.memory = block.memory;
+        allocation.memorySize = block.size;
+        allocation.offset = slot;
+        allocation.size = classSize;
+        allocation.mapped = block.mapped ? block.mapped + slot : nullptr;
+        allocation.memoryType = memoryType;
+        allocation.sizeClass = sizeClass;
+        freeList.push_back(allocation);
+    }
+}
+
+Allocation Allocator::allocate(uint32_t memoryType, VkMemoryRequirements memoryRequirements)
+{
+    // class sizes are powers of two no smaller than the alignment or a non-coherent atom,
+    // so slots carved at multiples of their size are always properly aligned
+    VkDeviceSize minimumSize = std::max(std::max(memoryRequirements.size, memoryRequirements.alignment),
+                                        context->physicalDeviceProperties.limits.nonCoherentAtomSize);
+    int sizeClass = MIN_CLASS_SHIFT;
+    while ((VkDeviceSize(1) << sizeClass) < minimumSize) {
+        sizeClass++;
+    }
+
+    if ((VkDeviceSize(1) << sizeClass) > blockSize / 4) {
+        Allocation allocation;
+        allocation.memory = allocateMemory(memoryType, memoryRequirements.size, &allocation.mapped);
+        allocation.memorySize = allocation.size = memoryRequirements.size;
+        allocation.memoryType = memoryType;
+        return allocation;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    std::vector<Allocation> &freeList = freeLists[std::make_pair(memoryType, sizeClass)];
+    if (freeList.empty()) {
+        carve(memoryType, sizeClass);
+    }
+
+    Allocation allocation = freeList.back();
+    freeList.pop_back();
+    return allocation;
+}
+
+void Allocator::free(Allocation allocation)
+{
+    if (allocation.sizeClass == -1) {
+        vkFreeMemory(device, allocation.memory, nullptr);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    freeLists[std::make_pair(allocation.memoryType, allocation.sizeClass)].push_back(allocation);
+}
+
+void Allocator::destroy()
+{
+    for (std::pair<const uint32_t, std::vector<Block>> &typeBlocks : blocks) {
+        for (Block &block : typeBlocks.second) {
+            vkFreeMemory(device, block.memory, nullptr);
+        }
+    }
+    blocks.clear();
+    freeLists.clear();
+}
+
+}
@@ -1,62 +1,81 @@
 #include "arguments.h"
+#include "descriptorallocator.h"
 
 namespace vc {
 
-Arguments::Arguments(Program &function, std::vector<Buffer> resources) : Program(function)
+Arguments::Arguments(Program &function, std::vector<BufferView> resources)
+    : Device(function), pipelineLayout(function.pipelineLayout), descriptorSetLayout(function.descriptorSetLayout),
+      resources(resources), resourceTypes(function.resourceTypes)
 {
-    // how many of each type
-    VkDescriptorPoolSize descriptorPoolSizes[] = {
-        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, (uint32_t) resources.size()}
-    };
-
-    VkDescriptorPoolCreateInfo descriptorPoolCreateInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
-    descriptorPoolCreateInfo.poolSizeCount = 1;
-    descriptorPoolCreateInfo.maxSets = 1;
-    descriptorPoolCreateInfo.pPoolSizes = descriptorPoolSizes;
-    if (VK_SUCCESS != vkCreateDescriptorPool(device, &descriptorPoolCreateInfo, nullptr, &descriptorPool)) {
+    if (resources.size() != resourceTypes.size()) {
         throw ERROR_SHADER;
     }
 
-    // allocate the descriptor set (according to the function's layout)
-    VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
-    descriptorSetAllocateInfo.descriptorSetCount = 1; // 1?
-    descriptorSetAllocateInfo.pSetLayouts = &descriptorSetLayout;
-    descriptorSetAllocateInfo.descriptorPool = descriptorPool;
+    // buffer ranges to bind
+    VkDeviceSize alignment = context->physicalDeviceProperties.limits.minStorageBufferOffsetAlignment;
+    for (size_t i = 0; i < resources.size(); i++) {
+        BufferView &view = resources[i];
+        if (view.offset % alignment || (view.bufferSize != VK_WHOLE_SIZE && view.size != VK_WHOLE_SIZE &&
+                                        view.offset + view.size > view.bufferSize)) {
+            throw ERROR_SHADER;
+        }
 
-    if (VK_SUCCESS != vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, &descriptorSet)) {
-        throw ERROR_SHADER;
+        // dynamic offsets move the window, it needs a size and a buffer to stay within
+        if (resourceTypes[i] == BUFFER_DYNAMIC) {
+            if (view.size == VK_WHOLE_SIZE || view.bufferSize == VK_WHOLE_SIZE) {
+                throw ERROR_SHADER;
+            }
+            numDynamic++;
+        }
     }
+    allocate();
+}
 
-    // bind to this
-
-    // buffers to bind
-    VkDescriptorBufferInfo *descriptorBufferInfo = new VkDescriptorBufferInfo[resources.size()];
-    for (uint32_t i = 0; i < resources.size(); i++) {
-        descriptorBufferInfo[i].buffer = resources[i];
-        descriptorBufferInfo[i].offset = 0;
-        descriptorBufferInfo[i].range = VK_WHOLE_SIZE;
+void Arguments::allocate()
+{
+    std::vector<VkDescriptorBufferInfo> descriptorBufferInfos;
+    for (BufferView &view : resources) {
+        descriptorBufferInfos.push_back({view.buffer, view.offset, view.size});
     }
 
-    // bind stuff here
-    VkWriteDescriptorSet writeDescriptorSet = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-    writeDescriptorSet.dstSet = descriptorSet;//pipeline.getDescriptorSet();
-    writeDescriptorSet.dstBinding = 0;
-    writeDescriptorSet.descriptorCount = resources.size();
-    writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    writeDescriptorSet.pBufferInfo = descriptorBufferInfo;
-    vkUpdateDescriptorSets(device, 1, &writeDescriptorSet, 0, nullptr);
-    delete [] descriptorBufferInfo;
+    // an identical set from earlier is reused as is. The generation is read first, a reset
+    // in between only makes the next bind allocate once more
+    generation = context->descriptorAllocator->getGeneration();
+    descriptorSet = context->descriptorAllocator->get(descriptorSetLayout, descriptorBufferInfos, resourceTypes);
 }
 
-void Arguments::bindTo(VkCommandBuffer commandBuffer)
+void Arguments::bindTo(VkCommandBuffer commandBuffer, std::vector<uint32_t> dynamicOffsets)
 {
-    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+    VkDeviceSize alignment = context->physicalDeviceProperties.limits.minStorageBufferOffsetAlignment;
+    if (dynamicOffsets.empty()) {
+        dynamicOffsets.resize(numDynamic, 0);
+    }
+    if (dynamicOffsets.size() != numDynamic) {
+        throw ERROR_COMMAND;
+    }
+    std::vector<uint32_t>::iterator offset = dynamicOffsets.begin();
+    for (size_t i = 0; i < resources.size(); i++) {
+        if (resourceTypes[i] == BUFFER_DYNAMIC) {
+            BufferView &view = resources[i];
+            if (*offset % alignment || view.offset + *offset + view.size > view.bufferSize) {
+                throw ERROR_COMMAND;
+            }
+            offset++;
+        }
+    }
+
+    // sets made before Device::resetDescriptorSets() are gone, this one is made again
+    if (generation != context->descriptorAllocator->getGeneration()) {
+        allocate();
+    }
+
+    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &descriptorSet,
+                            dynamicOffsets.size(), dynamicOffsets.data());
 }
 
 void Arguments::destroy()
 {
-    vkFreeDescriptorSets(device, descriptorPool, 1, &descriptorSet);
-    vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    // the descriptor set is owned by the device's descriptor allocator
 }
 
 }
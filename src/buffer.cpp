@@ -1,66 +1,252 @@
 #include "buffer.h"
+#include "stagingring.h"
+#include "descriptorallocator.h"
+#include <algorithm>
 
 namespace vc {
 
-Buffer::Buffer(Device &device, size_t byteSize, bool mappable) : Device(device)
+BufferView::BufferView(VkBuffer buffer) : buffer(buffer), offset(0), size(VK_WHOLE_SIZE), bufferSize(VK_WHOLE_SIZE)
+{
+
+}
+
+BufferView::BufferView(Buffer &buffer) : buffer(buffer), offset(0), size(VK_WHOLE_SIZE), bufferSize(buffer.size())
+{
+
+}
+
+BufferView::BufferView(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, VkDeviceSize bufferSize)
+    : buffer(buffer), offset(offset), size(size), bufferSize(bufferSize)
+{
+
+}
+
+void Buffer::createBuffer(const void *next)
 {
-    // create buffer
     VkBufferCreateInfo bufferCreateInfo = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    bufferCreateInfo.pNext = next;
     bufferCreateInfo.size = byteSize;
-    bufferCreateInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferCreateInfo.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                             VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+
+    // shared with the transfer queue without explicit ownership transfers
+    uint32_t queueFamilies[] = {(uint32_t) context->computeQueueFamily, (uint32_t) context->transferQueueFamily};
+    if (context->transferQueueFamily != -1) {
+        bufferCreateInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        bufferCreateInfo.queueFamilyIndexCount = 2;
+        bufferCreateInfo.pQueueFamilyIndices = queueFamilies;
+    }
+
     if (VK_SUCCESS != vkCreateBuffer(this->device, &bufferCreateInfo, nullptr, &buffer)) {
         throw ERROR_MALLOC;
     }
+}
+
+Buffer::Buffer(Device &device, size_t byteSize, bool mappable) : Device(device), byteSize(byteSize)
+{
+    // create buffer
+    createBuffer(nullptr);
 
     // get memory requirements
     VkMemoryRequirements memoryRequirements;
     vkGetBufferMemoryRequirements(this->device, buffer, &memoryRequirements);
 
-    // allocate memory for the buffer
-    VkMemoryAllocateInfo memoryAllocateInfo = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-    memoryAllocateInfo.allocationSize = memoryRequirements.size;
-    memoryAllocateInfo.memoryTypeIndex = mappable ? memoryTypeMappable : memoryTypeLocal;
-    if (VK_SUCCESS != vkAllocateMemory(this->device, &memoryAllocateInfo, nullptr, &memory)) {
+    // suballocate memory for the buffer
+    allocation = context->allocator->allocate(mappable ? context->memoryTypeMappable : context->memoryTypeLocal, memoryRequirements);
+
+    // bind memory to the buffer
+    if (VK_SUCCESS != vkBindBufferMemory(this->device, buffer, allocation.memory, allocation.offset)) {
+        context->allocator->free(allocation);
+        vkDestroyBuffer(this->device, buffer, nullptr);
         throw ERROR_MALLOC;
     }
+}
 
-    // bind memory to the buffer
-    if (VK_SUCCESS != vkBindBufferMemory(this->device, buffer, memory, 0)) {
+Buffer::Buffer(Device &device, void *hostPtr, size_t byteSize) : Device(device), byteSize(byteSize)
+{
+    if (importHostMemory(hostPtr)) {
+        return;
+    }
+
+    // without the extension (or for unsuitable pointers) upload and download stage as usual
+    createBuffer(nullptr);
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(this->device, buffer, &memoryRequirements);
+    allocation = context->allocator->allocate(context->memoryTypeLocal, memoryRequirements);
+    if (VK_SUCCESS != vkBindBufferMemory(this->device, buffer, allocation.memory, allocation.offset)) {
+        context->allocator->free(allocation);
+        vkDestroyBuffer(this->device, buffer, nullptr);
         throw ERROR_MALLOC;
     }
 }
 
+Buffer::Buffer(Buffer &&buffer) noexcept
+    : Device(buffer), allocation(buffer.allocation), buffer(buffer.buffer), byteSize(buffer.byteSize), imported(buffer.imported)
+{
+    buffer.buffer = VK_NULL_HANDLE;
+}
+
+Buffer &Buffer::operator=(Buffer &&buffer) noexcept
+{
+    if (this != &buffer) {
+        destroy();
+        Device::operator=(buffer);
+        allocation = buffer.allocation;
+        this->buffer = buffer.buffer;
+        byteSize = buffer.byteSize;
+        imported = buffer.imported;
+        buffer.buffer = VK_NULL_HANDLE;
+    }
+    return *this;
+}
+
+Buffer::~Buffer()
+{
+    destroy();
+}
+
+bool Buffer::importHostMemory(void *hostPtr)
+{
+    if (!context->getMemoryHostPointerProperties) {
+        return false;
+    }
+
+    VkMemoryHostPointerPropertiesEXT memoryHostPointerProperties = {VK_STRUCTURE_TYPE_MEMORY_HOST_POINTER_PROPERTIES_EXT};
+    if (VK_SUCCESS != context->getMemoryHostPointerProperties(device, VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT,
+                                                     hostPtr, &memoryHostPointerProperties)) {
+        return false;
+    }
+
+    VkExternalMemoryBufferCreateInfo externalMemoryBufferCreateInfo = {VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_BUFFER_CREATE_INFO};
+    externalMemoryBufferCreateInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+    createBuffer(&externalMemoryBufferCreateInfo);
+
+    VkMemoryRequirements memoryRequirements;
+    vkGetBufferMemoryRequirements(device, buffer, &memoryRequirements);
+
+    // imported memory is never mapped through Vulkan, so it must not need flushing
+    VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(context->physicalDevice, &physicalDeviceMemoryProperties);
+    uint32_t memoryTypeBits = memoryRequirements.memoryTypeBits & memoryHostPointerProperties.memoryTypeBits;
+    int memoryType = -1;
+    for (uint32_t i = 0; i < physicalDeviceMemoryProperties.memoryTypeCount; i++) {
+        if ((memoryTypeBits & (1 << i)) && (physicalDeviceMemoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+            memoryType = i;
+            break;
+        }
+    }
+
+    // pointer and size must be aligned to minImportedHostPointerAlignment, the allocation fails otherwise
+    VkImportMemoryHostPointerInfoEXT importMemoryHostPointerInfo = {VK_STRUCTURE_TYPE_IMPORT_MEMORY_HOST_POINTER_INFO_EXT};
+    importMemoryHostPointerInfo.handleType = VK_EXTERNAL_MEMORY_HANDLE_TYPE_HOST_ALLOCATION_BIT_EXT;
+    importMemoryHostPointerInfo.pHostPointer = hostPtr;
+    VkMemoryAllocateInfo memoryAllocateInfo = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    memoryAllocateInfo.pNext = &importMemoryHostPointerInfo;
+    memoryAllocateInfo.allocationSize = byteSize;
+    memoryAllocateInfo.memoryTypeIndex = memoryType;
+    if (memoryType == -1 || memoryRequirements.size > byteSize ||
+        VK_SUCCESS != vkAllocateMemory(device, &memoryAllocateInfo, nullptr, &allocation.memory)) {
+        vkDestroyBuffer(device, buffer, nullptr);
+        return false;
+    }
+
+    if (VK_SUCCESS != vkBindBufferMemory(device, buffer, allocation.memory, 0)) {
+        vkFreeMemory(device, allocation.memory, nullptr);
+        vkDestroyBuffer(device, buffer, nullptr);
+        return false;
+    }
+
+    allocation.memorySize = allocation.size = byteSize;
+    allocation.mapped = (char *) hostPtr;
+    allocation.memoryType = memoryType;
+    imported = true;
+    return true;
+}
+
 void Buffer::fill(uint32_t value)
 {
-    implicitCommandBuffer->begin();
-    vkCmdFillBuffer(*implicitCommandBuffer, buffer, 0, VK_WHOLE_SIZE, value);
-    implicitCommandBuffer->end();
-    submit(*implicitCommandBuffer);
-    wait();
+    // mapped memory is filled by the host once the device is done with it
+    if (allocation.mapped) {
+        context->stagingRing->synchronizeHost();
+        std::fill_n((uint32_t *) allocation.mapped, byteSize / sizeof(uint32_t), value);
+        flush(0, byteSize);
+        return;
+    }
+
+    VkCommandBuffer commandBuffer = acquireCommandBuffer();
+    vkCmdFillBuffer(commandBuffer, buffer, 0, VK_WHOLE_SIZE, value);
+    submitAcquired(commandBuffer).wait();
 }
 
-void Buffer::enqueueCopy(Buffer src, Buffer dst, size_t byteSize, VkCommandBuffer commandBuffer)
+void Buffer::enqueueCopy(Buffer &src, Buffer &dst, size_t byteSize, VkCommandBuffer commandBuffer)
 {
     VkBufferCopy bufferCopy = {0, 0, byteSize};
     vkCmdCopyBuffer(commandBuffer, src.buffer, dst.buffer, 1, &bufferCopy);
 }
 
-void Buffer::download(void *hostPtr)
+void Buffer::enqueueCopy(Buffer &src, Buffer &dst, std::vector<VkBufferCopy> regions, VkCommandBuffer commandBuffer)
 {
-    VkMemoryRequirements memoryRequirements;
-    vkGetBufferMemoryRequirements(this->device, buffer, &memoryRequirements);
+    if (regions.size()) {
+        vkCmdCopyBuffer(commandBuffer, src.buffer, dst.buffer, regions.size(), regions.data());
+    }
+}
 
-    Buffer mappable(*this, memoryRequirements.size, memoryTypeMappable);
+void Buffer::upload(const void *hostPtr, size_t byteSize, size_t offset)
+{
+    // the same range rules as view(), checked before any memory is touched or copy recorded
+    if (offset > this->byteSize || (byteSize != VK_WHOLE_SIZE && byteSize > this->byteSize - offset)) {
+        throw ERROR_MALLOC;
+    }
+    if (byteSize == VK_WHOLE_SIZE) {
+        byteSize = this->byteSize - offset;
+    }
 
-    implicitCommandBuffer->begin();
-    enqueueCopy(*this, mappable, memoryRequirements.size, *implicitCommandBuffer);
-    implicitCommandBuffer->end();
-    submit(*implicitCommandBuffer);
-    wait();
+    // mapped device memory (or imported host memory) is written in place, nothing to stage.
+    // Like a staged upload it waits for earlier compute work, which may still read it
+    if (allocation.mapped) {
+        context->stagingRing->synchronizeHost();
+        if (hostPtr != allocation.mapped + offset) {
+            memcpy(allocation.mapped + offset, hostPtr, byteSize);
+        }
+        flush(offset, byteSize);
+        return;
+    }
+    context->stagingRing->upload(buffer, hostPtr, byteSize, offset);
+}
 
-    memcpy(hostPtr, mappable.map(), memoryRequirements.size);
-    mappable.unmap();
-    mappable.destroy();
+void Buffer::download(void *hostPtr, size_t byteSize, size_t offset)
+{
+    // the same range rules as view(), checked before any memory is touched or copy recorded
+    if (offset > this->byteSize || (byteSize != VK_WHOLE_SIZE && byteSize > this->byteSize - offset)) {
+        throw ERROR_MALLOC;
+    }
+    if (byteSize == VK_WHOLE_SIZE) {
+        byteSize = this->byteSize - offset;
+    }
+
+    // only needs earlier device writes made visible to the host
+    if (allocation.mapped) {
+        context->stagingRing->synchronizeHost();
+        invalidate(offset, byteSize);
+        if (hostPtr != allocation.mapped + offset) {
+            memcpy(hostPtr, allocation.mapped + offset, byteSize);
+        }
+        return;
+    }
+    context->stagingRing->download(buffer, hostPtr, byteSize, offset);
+}
+
+size_t Buffer::size()
+{
+    return byteSize;
+}
+
+BufferView Buffer::view(size_t offset, size_t byteSize)
+{
+    if (offset > this->byteSize || (byteSize != VK_WHOLE_SIZE && byteSize > this->byteSize - offset)) {
+        throw ERROR_MALLOC;
+    }
+    return BufferView(buffer, offset, byteSize, this->byteSize);
 }
 
 Buffer::operator VkBuffer()
@@ -68,25 +254,79 @@ Buffer::operator VkBuffer()
     return buffer;
 }
 
+bool Buffer::isImported()
+{
+    return imported;
+}
+
 void Buffer::destroy()
 {
-    vkFreeMemory(device, memory, nullptr);
+    // moved from or destroyed already
+    if (buffer == VK_NULL_HANDLE) {
+        return;
+    }
+
+    context->descriptorAllocator->evict(buffer);
     vkDestroyBuffer(device, buffer, nullptr);
+    if (imported) {
+        vkFreeMemory(device, allocation.memory, nullptr);
+    } else {
+        context->allocator->free(allocation);
+    }
+    buffer = VK_NULL_HANDLE;
 }
 
 void Buffer::unmap()
 {
-    vkUnmapMemory(device, memory);
+    // host visible memory is persistently mapped by the allocator
 }
 
 void *Buffer::map()
 {
-    double *pointer;
-    if (VK_SUCCESS != vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, (void **) &pointer)) {
+    if (!allocation.mapped) {
+        throw ERROR_MAP;
+    }
+
+    return allocation.mapped;
+}
+
+VkMappedMemoryRange Buffer::mappedRange(size_t offset, size_t byteSize)
+{
+    // ranges must start and end on non-coherent atoms (or at the end of the memory)
+    VkDeviceSize atomSize = context->physicalDeviceProperties.limits.nonCoherentAtomSize;
+    VkMappedMemoryRange mappedMemoryRange = {VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE};
+    offset += allocation.offset;
+    mappedMemoryRange.memory = allocation.memory;
+    mappedMemoryRange.offset = (offset / atomSize) * atomSize;
+    mappedMemoryRange.size = ((offset + byteSize - mappedMemoryRange.offset + atomSize - 1) / atomSize) * atomSize;
+    if (mappedMemoryRange.offset + mappedMemoryRange.size > allocation.memorySize) {
+        mappedMemoryRange.size = VK_WHOLE_SIZE;
+    }
+    return mappedMemoryRange;
+}
+
+void Buffer::flush(size_t offset, size_t byteSize)
+{
+    if (imported) {
+        return;
+    }
+
+    VkMappedMemoryRange mappedMemoryRange = mappedRange(offset, byteSize);
+    if (VK_SUCCESS != vkFlushMappedMemoryRanges(device, 1, &mappedMemoryRange)) {
         throw ERROR_MAP;
     }
+}
+
+void Buffer::invalidate(size_t offset, size_t byteSize)
+{
+    if (imported) {
+        return;
+    }
 
-    return pointer;
+    VkMappedMemoryRange mappedMemoryRange = mappedRange(offset, byteSize);
+    if (VK_SUCCESS != vkInvalidateMappedMemoryRanges(device, 1, &mappedMemoryRange)) {
+        throw ERROR_MAP;
+    }
 }
 
 }
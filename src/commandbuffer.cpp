@@ -1,5 +1,8 @@
 #include "commandbuffer.h"
 #include "arguments.h"
+#include "profiler.h"
+#include "buffer.h"
+#include <algorithm>
 
 namespace vc {
 
@@ -7,14 +10,14 @@ void CommandBuffer::sharedConstructor()
 {
     VkCommandPoolCreateInfo commandPoolCreateInfo = {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
     commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-    commandPoolCreateInfo.queueFamilyIndex = this->computeQueueFamily;
+    commandPoolCreateInfo.queueFamilyIndex = context->computeQueueFamily;
     if (VK_SUCCESS != vkCreateCommandPool(this->device, &commandPoolCreateInfo, nullptr, &commandPool)) {
         throw ERROR_COMMAND;
     }
 
     VkCommandBufferAllocateInfo commandBufferAllocateInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
     commandBufferAllocateInfo.commandBufferCount = 1;
-    commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferAllocateInfo.level = secondary ? VK_COMMAND_BUFFER_LEVEL_SECONDARY : VK_COMMAND_BUFFER_LEVEL_PRIMARY;
     commandBufferAllocateInfo.commandPool = commandPool;
     if (VK_SUCCESS != vkAllocateCommandBuffers(this->device, &commandBufferAllocateInfo, &commandBuffer)) {
         throw ERROR_COMMAND;
@@ -24,21 +27,95 @@ void CommandBuffer::sharedConstructor()
 CommandBuffer::CommandBuffer(Device &device, Program &program, Arguments &arguments) : Device(device)
 {
     sharedConstructor();
-    arguments.bindTo(*this);
-    program.bindTo(*this);
+    begin();
+    bind(program, arguments);
 }
 
-CommandBuffer::CommandBuffer(Device &device) : Device(device)
+CommandBuffer::CommandBuffer(Device &device, bool secondary) : Device(device), secondary(secondary)
 {
     sharedConstructor();
 }
 
 CommandBuffer::CommandBuffer(Device &device, Program &program, Arguments &arguments);
 
+CommandBuffer::CommandBuffer(CommandBuffer &&commandBuffer) noexcept : Device(commandBuffer)
+{
+    *this = std::move(commandBuffer);
+}
+
+CommandBuffer &CommandBuffer::operator=(CommandBuffer &&commandBuffer) noexcept
+{
+    if (this != &commandBuffer) {
+        destroy();
+        Device::operator=(commandBuffer);
+        this->commandBuffer = commandBuffer.commandBuffer;
+        commandPool = commandBuffer.commandPool;
+        pipelineLayout = commandBuffer.pipelineLayout;
+        pushConstantSize = commandBuffer.pushConstantSize;
+        profiler = commandBuffer.profiler;
+        pending = std::move(commandBuffer.pending);
+        secondary = commandBuffer.secondary;
+        footprint = std::move(commandBuffer.footprint);
+        bound = std::move(commandBuffer.bound);
+        barrierCount = commandBuffer.barrierCount;
+        scratchBuffers = std::move(commandBuffer.scratchBuffers);
+        retired = std::move(commandBuffer.retired);
+        commandBuffer.commandBuffer = VK_NULL_HANDLE;
+        commandBuffer.commandPool = VK_NULL_HANDLE;
+        commandBuffer.profiler = nullptr;
+    }
+    return *this;
+}
+
+CommandBuffer::~CommandBuffer()
+{
+    destroy();
+}
+
 void CommandBuffer::destroy()
 {
+    // moved from or destroyed already
+    if (commandPool == VK_NULL_HANDLE) {
+        return;
+    }
+
+    if (profiler) {
+        profiler->destroy();
+        delete profiler;
+        profiler = nullptr;
+    }
+    freeScratch(scratchBuffers);
+    freeScratch(retired);
     vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
     vkDestroyCommandPool(device, commandPool, nullptr);
+    commandPool = VK_NULL_HANDLE;
+}
+
+VkBuffer CommandBuffer::scratch(unsigned int slot, VkDeviceSize byteSize)
+{
+    if (slot >= scratchBuffers.size()) {
+        scratchBuffers.resize(slot + 1, nullptr);
+    }
+
+    // this recording may already use the smaller buffer, keep it until the next begin()
+    if (!scratchBuffers[slot] || scratchBuffers[slot]->size() < byteSize) {
+        if (scratchBuffers[slot]) {
+            retired.push_back(scratchBuffers[slot]);
+        }
+        scratchBuffers[slot] = new Buffer(*this, byteSize);
+    }
+    return *scratchBuffers[slot];
+}
+
+void CommandBuffer::freeScratch(std::vector<Buffer *> &buffers)
+{
+    for (Buffer *buffer : buffers) {
+        if (buffer) {
+            buffer->destroy();
+            delete buffer;
+        }
+    }
+    buffers.clear();
 }
 
 CommandBuffer::operator VkCommandBuffer()
@@ -48,28 +125,311 @@ CommandBuffer::operator VkCommandBuffer()
 
 void CommandBuffer::begin()
 {
+    // secondaries may run from several primaries in flight at once
+    VkCommandBufferInheritanceInfo commandBufferInheritanceInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
     VkCommandBufferBeginInfo commandBufferBeginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    if (secondary) {
+        commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+        commandBufferBeginInfo.pInheritanceInfo = &commandBufferInheritanceInfo;
+    }
     if (VK_SUCCESS != vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo)) {
         throw ERROR_COMMAND;
     }
+
+    pending.clear();
+    footprint.clear();
+    bound.clear();
+    barrierCount = 0;
+    freeScratch(retired);
+    if (profiler) {
+        profiler->restart();
+    }
+}
+
+void CommandBuffer::bind(Program &program, Arguments &arguments, std::vector<uint32_t> dynamicOffsets)
+{
+    arguments.bindTo(commandBuffer, dynamicOffsets);
+    program.bindTo(commandBuffer);
+    pipelineLayout = program.pipelineLayout;
+    pushConstantSize = program.pushConstantSize;
+
+    // access is taken from the program being bound, the arguments may predate setAccess.
+    // Only the bound ranges are tracked, dispatches on disjoint slices need no barriers
+    bound.clear();
+    std::vector<uint32_t>::iterator dynamicOffset = dynamicOffsets.begin();
+    for (size_t i = 0; i < arguments.resources.size(); i++) {
+        BufferView &view = arguments.resources[i];
+        VkDeviceSize offset = view.offset;
+        if (arguments.resourceTypes[i] == BUFFER_DYNAMIC && dynamicOffset != dynamicOffsets.end()) {
+            offset += *dynamicOffset++;
+        }
+
+        Access access = i < program.access.size() ? program.access[i] : READ_WRITE;
+        VkAccessFlags accessFlags = ((access & READ) ? VK_ACCESS_SHADER_READ_BIT : 0) |
+                                    ((access & WRITE) ? VK_ACCESS_SHADER_WRITE_BIT : 0);
+        bound.push_back({view.buffer, {offset, view.size, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, accessFlags, (access & WRITE) != 0}});
+    }
+}
+
+void CommandBuffer::synchronize(std::vector<std::pair<VkBuffer, Range>> &uses)
+{
+    VkPipelineStageFlags srcStage = 0, dstStage = 0;
+    std::vector<VkBufferMemoryBarrier> bufferMemoryBarriers;
+    for (std::pair<VkBuffer, Range> &use : uses) {
+        VkDeviceSize begin = use.second.offset;
+        VkDeviceSize end = use.second.size == VK_WHOLE_SIZE ? VK_WHOLE_SIZE : begin + use.second.size;
+        VkDeviceSize useEnd = end;
+
+        // read after write, write after write and write after read on overlapping ranges. A write
+        // stays pending after a barrier, it is only visible to the stages and accesses waited on
+        VkBufferMemoryBarrier bufferMemoryBarrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+        bool hazard = false;
+        std::vector<Range> &ranges = pending[use.first];
+        for (std::vector<Range>::iterator range = ranges.begin(); range != ranges.end(); ) {
+            VkDeviceSize rangeEnd = range->size == VK_WHOLE_SIZE ? VK_WHOLE_SIZE : range->offset + range->size;
+            bool overlaps = range->offset < useEnd && use.second.offset < rangeEnd;
+            bool visible = (use.second.stage & ~range->visibleStage) == 0 && (use.second.access & ~range->visibleAccess) == 0;
+            if (!overlaps || !(use.second.write || (range->write && !visible))) {
+                range++;
+                continue;
+            }
+
+            hazard = true;
+            srcStage |= range->stage;
+            if (range->write) {
+                bufferMemoryBarrier.srcAccessMask |= range->access;
+            }
+            begin = std::min(begin, range->offset);
+            end = std::max(end, rangeEnd);
+
+            // what the new write covers completely is replaced by it
+            if (use.second.write && use.second.offset <= range->offset && rangeEnd <= useEnd) {
+                range = ranges.erase(range);
+            } else {
+                range->visibleStage |= use.second.stage;
+                range->visibleAccess |= use.second.access;
+                range++;
+            }
+        }
+
+        if (hazard) {
+            bufferMemoryBarrier.dstAccessMask = use.second.access;
+            bufferMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufferMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufferMemoryBarrier.buffer = use.first;
+            bufferMemoryBarrier.offset = begin;
+            bufferMemoryBarrier.size = end == VK_WHOLE_SIZE ? VK_WHOLE_SIZE : end - begin;
+            bufferMemoryBarriers.push_back(bufferMemoryBarrier);
+            dstStage |= use.second.stage;
+        }
+    }
+
+    if (bufferMemoryBarriers.size()) {
+        vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr,
+                             bufferMemoryBarriers.size(), bufferMemoryBarriers.data(), 0, nullptr);
+        barrierCount++;
+    }
+
+    // recorded only after checking every use so that a command never waits on itself
+    for (std::pair<VkBuffer, Range> &use : uses) {
+        track(pending, use);
+        if (secondary) {
+            track(footprint, use);
+        }
+    }
+}
+
+void CommandBuffer::track(std::map<VkBuffer, std::vector<Range>> &tracked, std::pair<VkBuffer, Range> &use)
+{
+    std::vector<Range> &ranges = tracked[use.first];
+    std::vector<Range>::iterator range = std::find_if(ranges.begin(), ranges.end(), [&use](const Range &range) {
+        return range.offset == use.second.offset && range.size == use.second.size && range.write == use.second.write;
+    });
+    if (range != ranges.end()) {
+        range->stage |= use.second.stage;
+        range->access |= use.second.access;
+        range->visibleStage = 0;
+        range->visibleAccess = 0;
+    } else {
+        ranges.push_back(use.second);
+    }
 }
 
 void CommandBuffer::barrier()
 {
+    // everything recorded so far becomes visible to everything after
+    VkMemoryBarrier memoryBarrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    memoryBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
     vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    pending.clear();
+    barrierCount++;
+}
+
+std::vector<std::pair<VkBuffer, CommandBuffer::Range>> CommandBuffer::boundUses()
+{
+    return bound;
 }
 
 void CommandBuffer::dispatch(int x, int y, int z)
 {
+    std::vector<std::pair<VkBuffer, Range>> uses = boundUses();
+    synchronize(uses);
+
+    if (profiler) {
+        profiler->beginDispatch(commandBuffer);
+        vkCmdDispatch(commandBuffer, x, y, z);
+        profiler->endDispatch(commandBuffer);
+        return;
+    }
     vkCmdDispatch(commandBuffer, x, y, z);
 }
 
+void CommandBuffer::dispatchIndirect(VkBuffer buffer, VkDeviceSize offset)
+{
+    // the workgroup counts are read as an indirect command, not by the shader
+    std::vector<std::pair<VkBuffer, Range>> uses = boundUses();
+    uses.push_back({buffer, {offset, sizeof(VkDispatchIndirectCommand), VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                             VK_ACCESS_INDIRECT_COMMAND_READ_BIT, false}});
+    synchronize(uses);
+
+    if (profiler) {
+        profiler->beginDispatch(commandBuffer);
+        vkCmdDispatchIndirect(commandBuffer, buffer, offset);
+        profiler->endDispatch(commandBuffer);
+        return;
+    }
+    vkCmdDispatchIndirect(commandBuffer, buffer, offset);
+}
+
+void CommandBuffer::copy(VkBuffer src, VkBuffer dst, VkDeviceSize byteSize, VkDeviceSize srcOffset, VkDeviceSize dstOffset)
+{
+    copy(src, dst, {{srcOffset, dstOffset, byteSize}});
+}
+
+void CommandBuffer::copy(VkBuffer src, VkBuffer dst, std::vector<VkBufferCopy> regions)
+{
+    if (regions.empty()) {
+        return;
+    }
+
+    std::vector<std::pair<VkBuffer, Range>> uses;
+    for (VkBufferCopy &region : regions) {
+        uses.push_back({src, {region.srcOffset, region.size, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, false}});
+        uses.push_back({dst, {region.dstOffset, region.size, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, true}});
+    }
+    synchronize(uses);
+    vkCmdCopyBuffer(commandBuffer, src, dst, regions.size(), regions.data());
+}
+
+void CommandBuffer::execute(CommandBuffer &secondary)
+{
+    if (this->secondary || !secondary.secondary) {
+        throw ERROR_COMMAND;
+    }
+
+    // what is pending here is ordered against everything the secondary accesses, the
+    // secondary then counts as accessing all of it
+    std::vector<std::pair<VkBuffer, Range>> uses;
+    for (std::pair<const VkBuffer, std::vector<Range>> &buffer : secondary.footprint) {
+        for (Range &range : buffer.second) {
+            uses.push_back({buffer.first, range});
+        }
+    }
+    synchronize(uses);
+    vkCmdExecuteCommands(commandBuffer, 1, &secondary.commandBuffer);
+
+    // pipeline, descriptor sets and push constants don't carry over from a secondary
+    bound.clear();
+    pipelineLayout = VK_NULL_HANDLE;
+    pushConstantSize = 0;
+}
+
+unsigned int CommandBuffer::getBarrierCount()
+{
+    return barrierCount;
+}
+
+void CommandBuffer::pushConstants(const void *data, uint32_t byteSize, uint32_t offset)
+{
+    // must fit the range declared by the bound program
+    if (offset % 4 || offset + byteSize > pushConstantSize) {
+        throw ERROR_COMMAND;
+    }
+    vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, offset, byteSize, data);
+}
+
 void CommandBuffer::end()
 {
+    if (profiler) {
+        profiler->end();
+    }
+
+    // order what is still pending against work submitted after this command buffer,
+    // for a secondary the primary executing it does
+    if (pending.size() && !secondary) {
+        VkPipelineStageFlags srcStage = 0;
+        VkMemoryBarrier memoryBarrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+        for (std::pair<const VkBuffer, std::vector<Range>> &buffer : pending) {
+            for (Range &range : buffer.second) {
+                srcStage |= range.stage;
+                memoryBarrier.srcAccessMask |= range.write ? range.access : 0;
+            }
+        }
+        if (srcStage) {
+            memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+            vkCmdPipelineBarrier(commandBuffer, srcStage, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                                 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+            barrierCount++;
+        }
+        pending.clear();
+    }
+
     if (VK_SUCCESS != vkEndCommandBuffer(commandBuffer)) {
         throw ERROR_COMMAND;
     }
 }
 
+void CommandBuffer::enableProfiling(uint32_t maxMarkers)
+{
+    if (!profiler) {
+        profiler = new Profiler(*this, maxMarkers);
+    }
+}
+
+void CommandBuffer::beginScope(const char *name)
+{
+    if (profiler) {
+        profiler->beginScope(commandBuffer, name);
+    }
+}
+
+void CommandBuffer::endScope()
+{
+    if (profiler) {
+        profiler->endScope(commandBuffer);
+    }
+}
+
+void CommandBuffer::collectProfile()
+{
+    // call once per completed execution, results are accumulated
+    if (profiler) {
+        profiler->collect();
+    }
+}
+
+std::vector<ProfileEntry> CommandBuffer::getProfile()
+{
+    return profiler ? profiler->report() : std::vector<ProfileEntry>();
+}
+
+void CommandBuffer::exportChromeTrace(std::ostream &out)
+{
+    if (profiler) {
+        profiler->exportChromeTrace(out);
+    }
+}
+
 }
@@ -0,0 +1,83 @@
+#include "commandrecycler.h"
+
+namespace vc {
+
+CommandRecycler::CommandRecycler(Device &device) : Device(device)
+{
+
+}
+
+CommandRecycler::Pool &CommandRecycler::threadPool()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    Pool *&pool = pools[std::this_thread::get_id()];
+    if (!pool) {
+        pool = new Pool;
+        VkCommandPoolCreateInfo commandPoolCreateInfo = {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+        commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        commandPoolCreateInfo.queueFamilyIndex = context->computeQueueFamily;
+        if (VK_SUCCESS != vkCreateCommandPool(device, &commandPoolCreateInfo, nullptr, &pool->commandPool)) {
+            delete pool;
+            pool = nullptr;
+            throw ERROR_COMMAND;
+        }
+    }
+    return *pool;
+}
+
+VkCommandBuffer CommandRecycler::acquire()
+{
+    Pool &pool = threadPool();
+    for (size_t i = 0; i < pool.inFlight.size(); ) {
+        if (pool.inFlight[i].second.poll()) {
+            pool.free.push_back(pool.inFlight[i].first);
+            pool.inFlight[i] = pool.inFlight.back();
+            pool.inFlight.pop_back();
+        } else {
+            i++;
+        }
+    }
+
+    VkCommandBuffer commandBuffer;
+    if (pool.free.size()) {
+        commandBuffer = pool.free.back();
+        pool.free.pop_back();
+    } else {
+        VkCommandBufferAllocateInfo commandBufferAllocateInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+        commandBufferAllocateInfo.commandBufferCount = 1;
+        commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandBufferAllocateInfo.commandPool = pool.commandPool;
+        if (VK_SUCCESS != vkAllocateCommandBuffers(device, &commandBufferAllocateInfo, &commandBuffer)) {
+            throw ERROR_COMMAND;
+        }
+    }
+
+    // beginning implicitly resets what was recorded before
+    VkCommandBufferBeginInfo commandBufferBeginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (VK_SUCCESS != vkBeginCommandBuffer(commandBuffer, &commandBufferBeginInfo)) {
+        throw ERROR_COMMAND;
+    }
+    return commandBuffer;
+}
+
+void CommandRecycler::release(VkCommandBuffer commandBuffer, Completion completion)
+{
+    threadPool().inFlight.push_back({commandBuffer, completion});
+}
+
+void CommandRecycler::destroy()
+{
+    for (std::pair<const std::thread::id, Pool *> &pool : pools) {
+        for (std::pair<VkCommandBuffer, Completion> &inFlight : pool.second->inFlight) {
+            inFlight.second.wait();
+        }
+
+        // destroying the pool frees its command buffers
+        vkDestroyCommandPool(device, pool.second->commandPool, nullptr);
+        delete pool.second;
+    }
+    pools.clear();
+}
+
+}
@@ -0,0 +1,35 @@
+#include "completion.h"
+#include "fencepool.h"
+
+namespace vc {
+
+Completion::Completion()
+{
+
+}
+
+Completion::Completion(FencePool *fencePool, void *record, uint64_t generation) : fencePool(fencePool), record(record), generation(generation)
+{
+
+}
+
+bool Completion::poll()
+{
+    return !fencePool || fencePool->poll(record, generation);
+}
+
+bool Completion::wait(uint64_t timeout)
+{
+    return !fencePool || fencePool->wait(record, generation, timeout);
+}
+
+void Completion::then(std::function<void()> callback)
+{
+    if (!fencePool) {
+        callback();
+        return;
+    }
+    fencePool->then(record, generation, callback);
+}
+
+}
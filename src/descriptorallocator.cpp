@@ -0,0 +1,176 @@
+#include "descriptorallocator.h"
+#include <algorithm>
+#include <iterator>
+
+namespace vc {
+
+static const uint32_t PAGE_SETS = 256;
+static const uint32_t PAGE_STORAGE_BUFFERS = 1024;
+static const uint32_t PAGE_STORAGE_BUFFERS_DYNAMIC = 256;
+
+// layout, then buffer, offset, range and resource type of every binding
+static const size_t KEY_STRIDE = 4;
+
+DescriptorAllocator::DescriptorAllocator(Device &device) : Device(device), generation(0)
+{
+
+}
+
+VkDescriptorSet DescriptorAllocator::allocate(VkDescriptorSetLayout descriptorSetLayout)
+{
+    VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    descriptorSetAllocateInfo.descriptorSetCount = 1;
+    descriptorSetAllocateInfo.pSetLayouts = &descriptorSetLayout;
+
+    // move on to the next page whenever the current one runs out, pages with freed sets
+    // before it are tried again first
+    VkDescriptorSet descriptorSet;
+    for (; ; currentPool++) {
+        bool created = currentPool == pools.size();
+        if (created) {
+            VkDescriptorPoolSize descriptorPoolSizes[] = {
+                {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, PAGE_STORAGE_BUFFERS},
+                {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, PAGE_STORAGE_BUFFERS_DYNAMIC}
+            };
+
+            VkDescriptorPoolCreateInfo descriptorPoolCreateInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+            descriptorPoolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+            descriptorPoolCreateInfo.poolSizeCount = 2;
+            descriptorPoolCreateInfo.maxSets = PAGE_SETS;
+            descriptorPoolCreateInfo.pPoolSizes = descriptorPoolSizes;
+
+            VkDescriptorPool descriptorPool;
+            if (VK_SUCCESS != vkCreateDescriptorPool(device, &descriptorPoolCreateInfo, nullptr, &descriptorPool)) {
+                throw ERROR_SHADER;
+            }
+            pools.push_back(descriptorPool);
+        }
+
+        descriptorSetAllocateInfo.descriptorPool = pools[currentPool];
+        VkResult result = vkAllocateDescriptorSets(device, &descriptorSetAllocateInfo, &descriptorSet);
+        if (result == VK_SUCCESS) {
+            return descriptorSet;
+        }
+
+        // a set that doesn't fit an empty page never will
+        if (created || (result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL)) {
+            throw ERROR_SHADER;
+        }
+    }
+}
+
+VkDescriptorSet DescriptorAllocator::get(VkDescriptorSetLayout descriptorSetLayout, std::vector<VkDescriptorBufferInfo> &bufferInfos,
+                                         std::vector<ResourceType> &resourceTypes)
+{
+    // BUFFER and BUFFER_DYNAMIC sets of the same ranges are written differently
+    Key key = {(uint64_t) descriptorSetLayout};
+    for (size_t i = 0; i < bufferInfos.size(); i++) {
+        key.push_back((uint64_t) bufferInfos[i].buffer);
+        key.push_back(bufferInfos[i].offset);
+        key.push_back(bufferInfos[i].range);
+        key.push_back(resourceTypes[i]);
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    std::map<Key, Entry>::iterator cached = cache.find(key);
+    if (cached != cache.end()) {
+        return cached->second.descriptorSet;
+    }
+
+    // one write per binding, their descriptor types may differ
+    VkDescriptorSet descriptorSet = allocate(descriptorSetLayout);
+    std::vector<VkWriteDescriptorSet> writeDescriptorSets(bufferInfos.size(), {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET});
+    for (size_t i = 0; i < bufferInfos.size(); i++) {
+        writeDescriptorSets[i].dstSet = descriptorSet;
+        writeDescriptorSets[i].dstBinding = i;
+        writeDescriptorSets[i].descriptorCount = 1;
+        writeDescriptorSets[i].descriptorType = (VkDescriptorType) resourceTypes[i];
+        writeDescriptorSets[i].pBufferInfo = &bufferInfos[i];
+    }
+    vkUpdateDescriptorSets(device, writeDescriptorSets.size(), writeDescriptorSets.data(), 0, nullptr);
+
+    cache[key] = {descriptorSet, currentPool};
+    for (VkDescriptorBufferInfo &bufferInfo : bufferInfos) {
+        buffers[bufferInfo.buffer].push_back(key);
+    }
+    return descriptorSet;
+}
+
+void DescriptorAllocator::release(std::map<Key, Entry>::iterator cached)
+{
+    // back to the pool it came from, which allocation tries again first
+    vkFreeDescriptorSets(device, pools[cached->second.pool], 1, &cached->second.descriptorSet);
+    currentPool = std::min(currentPool, cached->second.pool);
+
+    // every buffer of the set forgets it, a long lived buffer bound with many short lived
+    // ones would collect their keys otherwise
+    const Key &key = cached->first;
+    for (size_t i = 1; i < key.size(); i += KEY_STRIDE) {
+        std::map<VkBuffer, std::vector<Key>>::iterator keys = buffers.find((VkBuffer) key[i]);
+        if (keys != buffers.end()) {
+            keys->second.erase(std::remove(keys->second.begin(), keys->second.end(), key), keys->second.end());
+            if (keys->second.empty()) {
+                buffers.erase(keys);
+            }
+        }
+    }
+    cache.erase(cached);
+}
+
+void DescriptorAllocator::evict(VkBuffer buffer)
+{
+    // sets pointing at a destroyed buffer must never be handed out again. Nothing can use
+    // them anymore either, so they go back to their pool right away
+    std::unique_lock<std::mutex> lock(mutex);
+    std::map<VkBuffer, std::vector<Key>>::iterator keys = buffers.find(buffer);
+    if (keys != buffers.end()) {
+        std::vector<Key> evicted = keys->second;
+        for (Key &key : evicted) {
+            std::map<Key, Entry>::iterator cached = cache.find(key);
+            if (cached != cache.end()) {
+                release(cached);
+            }
+        }
+    }
+}
+
+void DescriptorAllocator::evictLayout(VkDescriptorSetLayout descriptorSetLayout)
+{
+    // keys start with their layout, so the sets of one layout are next to each other
+    std::unique_lock<std::mutex> lock(mutex);
+    std::map<Key, Entry>::iterator cached = cache.lower_bound(Key(1, (uint64_t) descriptorSetLayout));
+    while (cached != cache.end() && cached->first[0] == (uint64_t) descriptorSetLayout) {
+        std::map<Key, Entry>::iterator next = std::next(cached);
+        release(cached);
+        cached = next;
+    }
+}
+
+void DescriptorAllocator::reset()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    for (VkDescriptorPool descriptorPool : pools) {
+        vkResetDescriptorPool(device, descriptorPool, 0);
+    }
+    currentPool = 0;
+    cache.clear();
+    buffers.clear();
+    generation++;
+}
+
+uint64_t DescriptorAllocator::getGeneration()
+{
+    return generation;
+}
+
+void DescriptorAllocator::destroy()
+{
+    for (VkDescriptorPool descriptorPool : pools) {
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+    }
+    pools.clear();
+    cache.clear();
+    buffers.clear();
+}
+
+}
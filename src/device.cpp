@@ -1,98 +1,390 @@
 #include "device.h"
-#include "commandbuffer.h"
+#include "commandrecycler.h"
+#include "stagingring.h"
+#include "fencepool.h"
+#include "allocator.h"
+#include "queuesync.h"
+#include "pipelinecache.h"
+#include "descriptorallocator.h"
+#include <algorithm>
+#include <vector>
+#include <cstring>
 
 namespace vc {
 
-Device::Device(VkPhysicalDevice physicalDevice) : physicalDevice(physicalDevice)
+// the type with every required flag scoring highest, earlier preferences weigh more than later
+// ones and an avoided flag costs more than all preferences together. Ties go to the lower index
+static int findMemoryType(VkPhysicalDeviceMemoryProperties &memoryProperties, VkMemoryPropertyFlags required,
+                          std::vector<VkMemoryPropertyFlags> preferred, VkMemoryPropertyFlags avoided)
 {
+    int memoryType = -1, bestScore = 0;
+    for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+        VkMemoryPropertyFlags flags = memoryProperties.memoryTypes[i].propertyFlags;
+        if ((flags & required) != required) {
+            continue;
+        }
+
+        int score = (flags & avoided) ? 0 : 1 << preferred.size();
+        for (size_t j = 0; j < preferred.size(); j++) {
+            if ((flags & preferred[j]) == preferred[j]) {
+                score += 1 << (preferred.size() - 1 - j);
+            }
+        }
+        if (memoryType == -1 || score > bestScore) {
+            memoryType = i;
+            bestScore = score;
+        }
+    }
+    return memoryType;
+}
+
+Device::Device(VkPhysicalDevice physicalDevice, const char *pipelineCacheDirectory, VkInstance instance) : context(new DeviceContext)
+{
+    context->physicalDevice = physicalDevice;
+    vkGetPhysicalDeviceProperties(context->physicalDevice, &context->physicalDeviceProperties);
+
     // select a queue family with compute support
     uint32_t numQueues;
-    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &numQueues, nullptr);
+    vkGetPhysicalDeviceQueueFamilyProperties(context->physicalDevice, &numQueues, nullptr);
 
     VkQueueFamilyProperties *queueFamilyProperties = new VkQueueFamilyProperties[numQueues];
-    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &numQueues, queueFamilyProperties);
+    vkGetPhysicalDeviceQueueFamilyProperties(context->physicalDevice, &numQueues, queueFamilyProperties);
 
     for (uint32_t i = 0; i < numQueues; i++) {
         if (queueFamilyProperties[i].queueFlags & VK_QUEUE_COMPUTE_BIT) {
-            computeQueueFamily = i;
+            context->computeQueueFamily = i;
+            context->numComputeQueues = std::min<uint32_t>(queueFamilyProperties[i].queueCount, MAX_COMPUTE_QUEUES);
+            break;
+        }
+    }
+
+    // a transfer-only family is usually backed by dedicated copy engines
+    for (uint32_t i = 0; i < numQueues; i++) {
+        if ((queueFamilyProperties[i].queueFlags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_GRAPHICS_BIT)) == VK_QUEUE_TRANSFER_BIT) {
+            context->transferQueueFamily = i;
             break;
         }
     }
 
     delete [] queueFamilyProperties;
-    if (computeQueueFamily == -1) {
+    if (context->computeQueueFamily == -1) {
+        delete context;
         throw ERROR_DEVICES;
     }
 
-    VkDeviceQueueCreateInfo queueCreateInfo = {VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO};
-    queueCreateInfo.queueCount = 1;
-    float priorities[] = {1.0f};
-    queueCreateInfo.pQueuePriorities = priorities;
-    queueCreateInfo.queueFamilyIndex = computeQueueFamily;
+    VkDeviceQueueCreateInfo queueCreateInfos[2] = {{VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO}, {VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO}};
+    float priorities[MAX_COMPUTE_QUEUES] = {1.0f, 1.0f, 1.0f, 1.0f};
+    queueCreateInfos[0].queueCount = context->numComputeQueues;
+    queueCreateInfos[0].pQueuePriorities = priorities;
+    queueCreateInfos[0].queueFamilyIndex = context->computeQueueFamily;
+    queueCreateInfos[1].queueCount = 1;
+    queueCreateInfos[1].pQueuePriorities = priorities;
+    queueCreateInfos[1].queueFamilyIndex = context->transferQueueFamily;
 
-    // create the logical device
+    // host pointer import needs external memory as well, which is promoted to core in 1.1
+    uint32_t numExtensions;
+    vkEnumerateDeviceExtensionProperties(context->physicalDevice, nullptr, &numExtensions, nullptr);
+    std::vector<VkExtensionProperties> extensionProperties(numExtensions);
+    vkEnumerateDeviceExtensionProperties(context->physicalDevice, nullptr, &numExtensions, extensionProperties.data());
+
+    bool externalMemory = false, externalMemoryHost = false, timelineSemaphore = false;
+    for (VkExtensionProperties &extension : extensionProperties) {
+        externalMemory |= !strcmp(extension.extensionName, VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME);
+        externalMemoryHost |= !strcmp(extension.extensionName, VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME);
+        timelineSemaphore |= !strcmp(extension.extensionName, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+    }
+
+    std::vector<const char *> extensions;
+    bool importHostMemory = externalMemory && externalMemoryHost;
+    if (importHostMemory) {
+        extensions.push_back(VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME);
+        extensions.push_back(VK_EXT_EXTERNAL_MEMORY_HOST_EXTENSION_NAME);
+    }
+
+    // timeline semaphores build on 1.1, which the instance is created with when one is passed.
+    // The device has to be 1.1 as well, the extension alone doesn't say so
+    timelineSemaphore &= instance != VK_NULL_HANDLE && context->physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_1;
+    if (timelineSemaphore) {
+        extensions.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+    }
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES};
+    timelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
+
+    // 64-bit shader types are optional, enable them where present
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(context->physicalDevice, &supportedFeatures);
     VkPhysicalDeviceFeatures physicalDeviceFeatures = {};
+    physicalDeviceFeatures.shaderFloat64 = supportedFeatures.shaderFloat64;
+    physicalDeviceFeatures.shaderInt64 = supportedFeatures.shaderInt64;
+    context->float64 = supportedFeatures.shaderFloat64;
+
+    // create the logical device
     VkDeviceCreateInfo deviceCreateInfo = {VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
-    deviceCreateInfo.pQueueCreateInfos = &queueCreateInfo;
+    deviceCreateInfo.pNext = timelineSemaphore ? &timelineSemaphoreFeatures : nullptr;
+    deviceCreateInfo.pQueueCreateInfos = queueCreateInfos;
     deviceCreateInfo.pEnabledFeatures = &physicalDeviceFeatures;
-    deviceCreateInfo.queueCreateInfoCount = 1;
-    if (VK_SUCCESS != vkCreateDevice(physicalDevice, &deviceCreateInfo, nullptr, &device)) {
+    deviceCreateInfo.queueCreateInfoCount = context->transferQueueFamily == -1 ? 1 : 2;
+    deviceCreateInfo.enabledExtensionCount = extensions.size();
+    deviceCreateInfo.ppEnabledExtensionNames = extensions.data();
+    if (VK_SUCCESS != vkCreateDevice(context->physicalDevice, &deviceCreateInfo, nullptr, &device)) {
+        delete context;
         throw ERROR_DEVICES;
     }
 
-    vkGetDeviceQueue(device, computeQueueFamily, 0, &queue);
-    vkGetPhysicalDeviceProperties(physicalDevice, &physicalDeviceProperties);
+    if (importHostMemory) {
+        context->getMemoryHostPointerProperties = (PFN_vkGetMemoryHostPointerPropertiesEXT) vkGetDeviceProcAddr(device, "vkGetMemoryHostPointerPropertiesEXT");
+    }
+
+    if (timelineSemaphore) {
+        context->timelineWait = (PFN_vkWaitSemaphores) vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR");
+        context->timelineSignal = (PFN_vkSignalSemaphore) vkGetDeviceProcAddr(device, "vkSignalSemaphoreKHR");
+        context->timelineValue = (PFN_vkGetSemaphoreCounterValue) vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR");
+    }
+
+    for (unsigned int i = 0; i < context->numComputeQueues; i++) {
+        vkGetDeviceQueue(device, context->computeQueueFamily, i, &context->computeQueues[i]);
+    }
+    context->queue = context->computeQueues[0];
+
+    // without a transfer-only family copies go through the first compute queue
+    context->transferQueue = context->queue;
+    if (context->transferQueueFamily != -1) {
+        vkGetDeviceQueue(device, context->transferQueueFamily, 0, &context->transferQueue);
+    }
+
+    // subgroup properties are 1.1 only and the loader we link against is 1.0, so look them up
+    if (instance != VK_NULL_HANDLE && context->physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_1) {
+        PFN_vkGetPhysicalDeviceProperties2 getPhysicalDeviceProperties2 =
+            (PFN_vkGetPhysicalDeviceProperties2) vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2");
+        if (getPhysicalDeviceProperties2) {
+            VkPhysicalDeviceSubgroupProperties subgroupProperties = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES};
+            VkPhysicalDeviceProperties2 physicalDeviceProperties2 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+            physicalDeviceProperties2.pNext = &subgroupProperties;
+            getPhysicalDeviceProperties2(context->physicalDevice, &physicalDeviceProperties2);
+            context->subgroupSize = subgroupProperties.subgroupSize;
+            context->subgroupStages = subgroupProperties.supportedStages;
+            context->subgroupOperations = subgroupProperties.supportedOperations;
+        }
+    }
 
     // get indices of memory types we care about
     VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties;
-    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &physicalDeviceMemoryProperties);
-    for (uint32_t i = 0; i < physicalDeviceMemoryProperties.memoryTypeCount; i++) {
-        if (physicalDeviceMemoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT && memoryTypeMappable == -1) {
-            memoryTypeMappable = i;
-        }
+    vkGetPhysicalDeviceMemoryProperties(context->physicalDevice, &physicalDeviceMemoryProperties);
 
-        if (physicalDeviceMemoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT && memoryTypeLocal == -1) {
-            memoryTypeLocal = i;
-        }
+    // on integrated GPUs and CPU implementations device memory is host memory, buffers
+    // are then mapped directly instead of staged. Discrete GPUs keep host visible device
+    // memory (the BAR) for nothing, host reads from it are uncached
+    VkPhysicalDeviceType deviceType = context->physicalDeviceProperties.deviceType;
+    if (deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU || deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU) {
+        context->memoryTypeLocal = findMemoryType(physicalDeviceMemoryProperties, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                                         {VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT}, 0);
+        context->unifiedMemory = context->memoryTypeLocal != -1;
+    }
+    if (context->memoryTypeLocal == -1) {
+        context->memoryTypeLocal = findMemoryType(physicalDeviceMemoryProperties, 0, {VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT}, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
     }
 
-    // create the implicit command buffer
-    implicitCommandBuffer = new CommandBuffer(*this);
+    // coherent saves flushes, cached makes readback fast
+    context->memoryTypeMappable = findMemoryType(physicalDeviceMemoryProperties, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+                                        {VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT},
+                                        context->unifiedMemory ? 0 : VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    // a subsystem failing takes down the ones before it, the device and the context
+    try {
+        // create the allocator every buffer gets its memory from
+        context->allocator = new Allocator(*this);
+
+        // create the fence pool backing every submission
+        context->fencePool = new FencePool(*this);
+
+        // create the semaphores ordering transfers and compute work
+        context->queueSync = new QueueSync(*this);
+
+        // create the pipeline cache shared by every program
+        context->pipelineCache = new PipelineCache(*this, pipelineCacheDirectory);
+
+        // create the descriptor allocator shared by every set of arguments
+        context->descriptorAllocator = new DescriptorAllocator(*this);
+
+        // create the per-thread command pools for one-off work
+        context->commandRecycler = new CommandRecycler(*this);
+
+        // create the staging ring used by uploads and downloads
+        context->stagingRing = new StagingRing(*this);
+    } catch (...) {
+        destroy();
+        throw;
+    }
 }
 
 void Device::destroy()
 {
-    implicitCommandBuffer->destroy();
-    delete implicitCommandBuffer;
+    // subsystems are null when the constructor failed before creating them
+    if (context->stagingRing) {
+        context->stagingRing->destroy();
+        delete context->stagingRing;
+    }
+    if (context->commandRecycler) {
+        context->commandRecycler->destroy();
+        delete context->commandRecycler;
+    }
+    if (context->descriptorAllocator) {
+        context->descriptorAllocator->destroy();
+        delete context->descriptorAllocator;
+    }
+    if (context->pipelineCache) {
+        context->pipelineCache->destroy();
+        delete context->pipelineCache;
+    }
+    if (context->queueSync) {
+        context->queueSync->destroy();
+        delete context->queueSync;
+    }
+    if (context->fencePool) {
+        context->fencePool->destroy();
+        delete context->fencePool;
+    }
+    if (context->allocator) {
+        context->allocator->destroy();
+        delete context->allocator;
+    }
     vkDestroyDevice(device, nullptr);
+    delete context;
 }
 
-void Device::submit(VkCommandBuffer commandBuffer)
+Completion Device::submit(VkCommandBuffer commandBuffer, unsigned int queueIndex)
 {
+    if (queueIndex >= context->numComputeQueues) {
+        throw ERROR_DEVICES;
+    }
+
+    return context->queueSync->batchSubmit(queueIndex, {commandBuffer});
+}
+
+Completion Device::submit(std::vector<VkCommandBuffer> commandBuffers, unsigned int queueIndex)
+{
+    if (queueIndex >= context->numComputeQueues || commandBuffers.empty()) {
+        throw ERROR_DEVICES;
+    }
+    return context->queueSync->batchSubmit(queueIndex, commandBuffers);
+}
+
+VkCommandBuffer Device::acquireCommandBuffer()
+{
+    return context->commandRecycler->acquire();
+}
+
+Completion Device::submitAcquired(VkCommandBuffer commandBuffer, unsigned int queueIndex)
+{
+    if (VK_SUCCESS != vkEndCommandBuffer(commandBuffer)) {
+        throw ERROR_COMMAND;
+    }
+
+    Completion completion = submit(commandBuffer, queueIndex);
+    context->commandRecycler->release(commandBuffer, completion);
+    return completion;
+}
+
+SyncPoint Device::enqueue(VkCommandBuffer commandBuffer, std::vector<SyncPoint> after, unsigned int queueIndex)
+{
+    if (queueIndex >= context->numComputeQueues || !context->timelineWait) {
+        throw ERROR_DEVICES;
+    }
+
     VkSubmitInfo submitInfo = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
     submitInfo.commandBufferCount = 1;
     VkCommandBuffer commandBuffers[1] = {commandBuffer};
     submitInfo.pCommandBuffers = commandBuffers;
-    if (VK_SUCCESS != vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE)) {
+
+    SyncPoint point;
+    context->queueSync->computeSubmit(queueIndex, submitInfo, after, &point);
+    return point;
+}
+
+bool Device::wait(SyncPoint point, uint64_t timeout)
+{
+    if (!context->timelineWait) {
+        throw ERROR_DEVICES;
+    }
+
+    VkSemaphoreWaitInfo semaphoreWaitInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+    semaphoreWaitInfo.semaphoreCount = 1;
+    semaphoreWaitInfo.pSemaphores = &point.semaphore;
+    semaphoreWaitInfo.pValues = &point.value;
+    VkResult result = context->timelineWait(device, &semaphoreWaitInfo, timeout);
+    if (result != VK_SUCCESS && result != VK_TIMEOUT) {
         throw ERROR_DEVICES;
     }
+    return result == VK_SUCCESS;
+}
+
+bool Device::hasTimelineSemaphores()
+{
+    return context->timelineWait != nullptr;
 }
 
 void Device::wait()
 {
-    if (VK_SUCCESS != vkQueueWaitIdle(queue)) {
+    if (VK_SUCCESS != vkDeviceWaitIdle(device)) {
         throw ERROR_DEVICES;
     }
 }
 
+void Device::savePipelineCache()
+{
+    context->pipelineCache->save();
+}
+
+void Device::resetDescriptorSets()
+{
+    // only valid once no recorded command buffer uses any Arguments anymore. Arguments
+    // themselves stay usable, they allocate their set again when bound next
+    context->descriptorAllocator->reset();
+}
+
+bool Device::hasUnifiedMemory()
+{
+    return context->unifiedMemory;
+}
+
+bool Device::canImportHostMemory()
+{
+    return context->getMemoryHostPointerProperties != nullptr;
+}
+
+bool Device::hasFloat64()
+{
+    return context->float64;
+}
+
+bool Device::hasSubgroupArithmetic()
+{
+    return (context->subgroupStages & VK_SHADER_STAGE_COMPUTE_BIT) && (context->subgroupOperations & VK_SUBGROUP_FEATURE_ARITHMETIC_BIT);
+}
+
+uint32_t Device::getSubgroupSize()
+{
+    return context->subgroupSize;
+}
+
+unsigned int Device::getComputeQueueCount()
+{
+    return context->numComputeQueues;
+}
+
 const char *Device::getName()
 {
-    return physicalDeviceProperties.deviceName;
+    return context->physicalDeviceProperties.deviceName;
 }
 
 uint32_t Device::getVendorId()
 {
-    return physicalDeviceProperties.vendorID;
+    return context->physicalDeviceProperties.vendorID;
+}
+
+const VkPhysicalDeviceProperties &Device::getProperties()
+{
+    return context->physicalDeviceProperties;
 }
 
 }
@@ -1,10 +1,26 @@
 #include "devicepool.h"
+#include <thread>
+#include <algorithm>
 
 namespace vc {
 
-DevicePool::DevicePool()
+DevicePool::DevicePool(const char *pipelineCacheDirectory)
+    : pipelineCacheDirectory(pipelineCacheDirectory ? pipelineCacheDirectory : ""), hasPipelineCacheDirectory(pipelineCacheDirectory)
 {
+    // ask for 1.1 where the loader has it, devices then report their subgroup properties
+    apiVersion = VK_API_VERSION_1_0;
+    PFN_vkEnumerateInstanceVersion enumerateInstanceVersion =
+        (PFN_vkEnumerateInstanceVersion) vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion");
+    if (enumerateInstanceVersion && VK_SUCCESS == enumerateInstanceVersion(&apiVersion) && apiVersion >= VK_API_VERSION_1_1) {
+        apiVersion = VK_API_VERSION_1_1;
+    } else {
+        apiVersion = VK_API_VERSION_1_0;
+    }
+
+    VkApplicationInfo applicationInfo = {VK_STRUCTURE_TYPE_APPLICATION_INFO};
+    applicationInfo.apiVersion = apiVersion;
     VkInstanceCreateInfo instanceCreateInfo = {VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO};
+    instanceCreateInfo.pApplicationInfo = &applicationInfo;
     if (VK_SUCCESS != vkCreateInstance(&instanceCreateInfo, nullptr, &instance)) {
         throw ERROR_INSTANCE;
     }
@@ -14,20 +30,137 @@ DevicePool::DevicePool()
         throw ERROR_DEVICES;
     }
 
-    VkPhysicalDevice *physicalDevices = new VkPhysicalDevice[numDevices];
-    if (VK_SUCCESS != vkEnumeratePhysicalDevices(instance, &numDevices, physicalDevices)) {
+    std::vector<VkPhysicalDevice> handles(numDevices);
+    if (VK_SUCCESS != vkEnumeratePhysicalDevices(instance, &numDevices, handles.data())) {
         throw ERROR_DEVICES;
     }
 
-    for (uint32_t i = 0; i < numDevices; i++) {
-        devices.push_back(Device(physicalDevices[i]));
+    // only queries here, nothing is created
+    for (VkPhysicalDevice physicalDevice : handles) {
+        PhysicalDeviceInfo info;
+        info.physicalDevice = physicalDevice;
+        vkGetPhysicalDeviceProperties(physicalDevice, &info.properties);
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &info.memoryProperties);
+
+        uint32_t numQueueFamilies;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &numQueueFamilies, nullptr);
+        info.queueFamilies.resize(numQueueFamilies);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &numQueueFamilies, info.queueFamilies.data());
+
+        info.deviceLocalMemory = 0;
+        for (uint32_t i = 0; i < info.memoryProperties.memoryHeapCount; i++) {
+            if (info.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+                info.deviceLocalMemory += info.memoryProperties.memoryHeaps[i].size;
+            }
+        }
+        physicalDevices.push_back(info);
+    }
+    logicalDevices.resize(physicalDevices.size(), nullptr);
+}
+
+const std::vector<PhysicalDeviceInfo> &DevicePool::getPhysicalDevices()
+{
+    return physicalDevices;
+}
+
+std::vector<unsigned int> DevicePool::select(DeviceFilter filter)
+{
+    std::vector<unsigned int> indices;
+    for (unsigned int i = 0; i < physicalDevices.size(); i++) {
+        PhysicalDeviceInfo &info = physicalDevices[i];
+        bool queueFlags = !filter.queueFlags, dedicatedTransfer = !filter.dedicatedTransfer;
+        for (VkQueueFamilyProperties &queueFamily : info.queueFamilies) {
+            queueFlags |= (queueFamily.queueFlags & filter.queueFlags) == filter.queueFlags;
+            dedicatedTransfer |= (queueFamily.queueFlags & (VK_QUEUE_TRANSFER_BIT | VK_QUEUE_COMPUTE_BIT | VK_QUEUE_GRAPHICS_BIT)) == VK_QUEUE_TRANSFER_BIT;
+        }
+
+        if ((!filter.vendorId || filter.vendorId == info.properties.vendorID) &&
+            (filter.deviceTypes.empty() || std::count(filter.deviceTypes.begin(), filter.deviceTypes.end(), info.properties.deviceType)) &&
+            queueFlags && dedicatedTransfer &&
+            info.deviceLocalMemory >= filter.minDeviceLocalMemory &&
+            info.properties.apiVersion >= filter.minApiVersion) {
+            indices.push_back(i);
+        }
+    }
+    return indices;
+}
+
+void DevicePool::create(std::vector<unsigned int> indices)
+{
+    for (unsigned int index : indices) {
+        if (index >= physicalDevices.size()) {
+            throw ERROR_DEVICES;
+        }
+    }
+
+    // a device asked for twice would be created twice into the same slot
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+    std::unique_lock<std::mutex> lock(mutex);
+    std::vector<std::thread> threads;
+    std::vector<char> failed(indices.size(), false);
+    for (size_t i = 0; i < indices.size(); i++) {
+        unsigned int index = indices[i];
+        if (logicalDevices[index]) {
+            continue;
+        }
+
+        // logical devices of different physical devices don't share anything to synchronize
+        threads.push_back(std::thread([this, index, i, &failed]() {
+            try {
+                logicalDevices[index] = new Device(physicalDevices[index].physicalDevice,
+                                                   hasPipelineCacheDirectory ? pipelineCacheDirectory.c_str() : nullptr,
+                                                   apiVersion >= VK_API_VERSION_1_1 ? instance : VK_NULL_HANDLE);
+            } catch (...) {
+                // anything escaping the thread would terminate the process
+                failed[i] = true;
+            }
+        }));
     }
 
-    delete [] physicalDevices;
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    if (std::count(failed.begin(), failed.end(), true)) {
+        throw ERROR_DEVICES;
+    }
+}
+
+Device &DevicePool::getDevice(unsigned int index)
+{
+    create({index});
+    return *logicalDevices[index];
+}
+
+std::vector<Device> DevicePool::getDevices(DeviceFilter filter)
+{
+    std::vector<unsigned int> indices = select(filter);
+    create(indices);
+
+    std::vector<Device> selected;
+    for (unsigned int index : indices) {
+        selected.push_back(*logicalDevices[index]);
+    }
+    return selected;
 }
 
 std::vector<Device> &DevicePool::getDevices()
 {
+    std::vector<unsigned int> indices;
+    for (unsigned int i = 0; i < physicalDevices.size(); i++) {
+        indices.push_back(i);
+    }
+    create(indices);
+
+    // filled once by whoever gets here first, never changed after that
+    std::unique_lock<std::mutex> lock(mutex);
+    if (devices.size() != physicalDevices.size()) {
+        devices.clear();
+        for (Device *device : logicalDevices) {
+            devices.push_back(*device);
+        }
+    }
     return devices;
 }
 
@@ -0,0 +1,161 @@
+#include "fencepool.h"
+
+namespace vc {
+
+FencePool::FencePool(Device &device) : Device(device)
+{
+
+}
+
+FencePool::Record *FencePool::acquire()
+{
+    if (freeRecords.empty()) {
+        recycle();
+    }
+
+    if (freeRecords.size()) {
+        Record *record = freeRecords.back();
+        freeRecords.pop_back();
+        return record;
+    }
+
+    Record *record = new Record {VK_NULL_HANDLE, 0, 0};
+    VkFenceCreateInfo fenceCreateInfo = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+    if (VK_SUCCESS != vkCreateFence(device, &fenceCreateInfo, nullptr, &record->fence)) {
+        delete record;
+        throw ERROR_DEVICES;
+    }
+    records.push_back(record);
+    return record;
+}
+
+void FencePool::recycle()
+{
+    // signaled fences nobody is waiting on can be reset and handed out again,
+    // bumping the generation tells outstanding Completions they are done
+    for (std::deque<Record *>::iterator it = inFlight.begin(); it != inFlight.end(); ) {
+        Record *record = *it;
+        if (!record->waiters && vkGetFenceStatus(device, record->fence) == VK_SUCCESS) {
+            vkResetFences(device, 1, &record->fence);
+            record->generation++;
+            freeRecords.push_back(record);
+            it = inFlight.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+Completion FencePool::submit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo *submitInfos)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    Record *record = acquire();
+    if (VK_SUCCESS != vkQueueSubmit(queue, submitCount, submitInfos, record->fence)) {
+        freeRecords.push_back(record);
+        throw ERROR_DEVICES;
+    }
+    inFlight.push_back(record);
+    return Completion(this, record, record->generation);
+}
+
+bool FencePool::poll(void *record, uint64_t generation)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    Record *fenceRecord = (Record *) record;
+    return fenceRecord->generation != generation || vkGetFenceStatus(device, fenceRecord->fence) == VK_SUCCESS;
+}
+
+bool FencePool::wait(void *record, uint64_t generation, uint64_t timeout)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    Record *fenceRecord = (Record *) record;
+    if (fenceRecord->generation != generation) {
+        return true;
+    }
+
+    // waiters keep the fence from being reset underneath us
+    fenceRecord->waiters++;
+    lock.unlock();
+    VkResult result = vkWaitForFences(device, 1, &fenceRecord->fence, VK_TRUE, timeout);
+    lock.lock();
+    fenceRecord->waiters--;
+
+    if (result != VK_SUCCESS && result != VK_TIMEOUT) {
+        throw ERROR_DEVICES;
+    }
+    return result == VK_SUCCESS;
+}
+
+void FencePool::then(void *record, uint64_t generation, std::function<void()> callback)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    Record *fenceRecord = (Record *) record;
+    if (fenceRecord->generation == generation) {
+        fenceRecord->waiters++;
+    } else {
+        fenceRecord = nullptr;
+    }
+    callbacks.push_back({fenceRecord, generation, callback});
+
+    if (!running) {
+        running = true;
+        completionThread = std::thread(&FencePool::completionLoop, this);
+    }
+    condition.notify_one();
+}
+
+void FencePool::completionLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        condition.wait(lock, [this]() {
+            return !running || callbacks.size();
+        });
+
+        if (callbacks.empty()) {
+            return;
+        }
+
+        // callbacks run outside of the lock, one at a time in the order they were registered rather
+        // than the order of their submissions, so one still waiting holds back those after it
+        Callback callback = callbacks.front();
+        callbacks.pop_front();
+        lock.unlock();
+        if (callback.record) {
+            vkWaitForFences(device, 1, &callback.record->fence, VK_TRUE, UINT64_MAX);
+        }
+        callback.function();
+        lock.lock();
+
+        if (callback.record) {
+            callback.record->waiters--;
+        }
+    }
+}
+
+void FencePool::destroy()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (running) {
+        // pending callbacks are drained before the thread exits
+        running = false;
+        condition.notify_one();
+        lock.unlock();
+        completionThread.join();
+        lock.lock();
+    }
+
+    for (Record *record : inFlight) {
+        vkWaitForFences(device, 1, &record->fence, VK_TRUE, UINT64_MAX);
+    }
+
+    for (Record *record : records) {
+        vkDestroyFence(device, record->fence, nullptr);
+        delete record;
+    }
+    records.clear();
+    freeRecords.clear();
+    inFlight.clear();
+}
+
+}
@@ -0,0 +1,198 @@
+#include "graph.h"
+#include "arguments.h"
+#include <algorithm>
+
+namespace vc {
+
+Graph::Graph(Device &device) : Device(device)
+{
+
+}
+
+Graph::~Graph()
+{
+    destroy();
+}
+
+unsigned int Graph::buffer(size_t byteSize)
+{
+    resources.push_back({VK_NULL_HANDLE, byteSize, true, -1, -1, 0});
+    return resources.size() - 1;
+}
+
+unsigned int Graph::import(Buffer &buffer)
+{
+    resources.push_back({buffer, buffer.size(), false, -1, -1, 0});
+    return resources.size() - 1;
+}
+
+unsigned int Graph::dispatch(Program &program, std::vector<unsigned int> buffers, int x, int y, int z)
+{
+    if (buffers.size() != program.access.size()) {
+        throw ERROR_SHADER;
+    }
+    return addNode({&program, buffers, x, y, z, 0, 0, 0, 0}, program.access);
+}
+
+unsigned int Graph::copy(unsigned int src, unsigned int dst, size_t byteSize, size_t srcOffset, size_t dstOffset)
+{
+    if (src >= resources.size() || dst >= resources.size()) {
+        throw ERROR_COMMAND;
+    }
+    if (srcOffset > resources[src].byteSize || byteSize > resources[src].byteSize - srcOffset ||
+        dstOffset > resources[dst].byteSize || byteSize > resources[dst].byteSize - dstOffset) {
+        throw ERROR_MALLOC;
+    }
+    return addNode({nullptr, {src, dst}, 0, 0, 0, byteSize, srcOffset, dstOffset, 0}, {READ, WRITE});
+}
+
+unsigned int Graph::addNode(Node node, std::vector<Access> access)
+{
+    if (commandBuffer) {
+        throw ERROR_COMMAND;
+    }
+    if (node.buffers.size() && *std::max_element(node.buffers.begin(), node.buffers.end()) >= resources.size()) {
+        throw ERROR_COMMAND;
+    }
+
+    // one level past every earlier node that writes what it uses or uses what it writes
+    for (unsigned int i = 0; i < nodes.size(); i++) {
+        for (unsigned int j = 0; j < node.buffers.size(); j++) {
+            for (unsigned int k = 0; k < nodes[i].buffers.size(); k++) {
+                if (node.buffers[j] != nodes[i].buffers[k]) {
+                    continue;
+                }
+                Access earlier = nodes[i].program ? nodes[i].program->access[k] : (k ? WRITE : READ);
+                if ((earlier & WRITE) || (access[j] & WRITE)) {
+                    node.level = std::max(node.level, nodes[i].level + 1);
+                }
+            }
+        }
+    }
+
+    nodes.push_back(node);
+    numLevels = std::max(numLevels, node.level + 1);
+    for (unsigned int buffer : node.buffers) {
+        Resource &resource = resources[buffer];
+        resource.firstLevel = resource.firstLevel == -1 ? node.level : std::min<int>(resource.firstLevel, node.level);
+        resource.lastLevel = std::max<int>(resource.lastLevel, node.level);
+    }
+    return nodes.size() - 1;
+}
+
+void Graph::alias()
+{
+    // largest first, each transient goes into the first slot none of whose users overlap its levels
+    std::vector<unsigned int> order;
+    for (unsigned int i = 0; i < resources.size(); i++) {
+        if (resources[i].transient && resources[i].firstLevel != -1) {
+            order.push_back(i);
+            report.transientBytes += resources[i].byteSize;
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b) {
+        return resources[a].byteSize > resources[b].byteSize;
+    });
+
+    std::vector<std::vector<unsigned int>> users;
+    std::vector<size_t> slotSizes;
+    for (unsigned int i : order) {
+        Resource &resource = resources[i];
+        unsigned int slot = 0;
+        for (; slot < users.size(); slot++) {
+            bool overlaps = false;
+            for (unsigned int user : users[slot]) {
+                overlaps |= resource.firstLevel <= resources[user].lastLevel && resources[user].firstLevel <= resource.lastLevel;
+            }
+            if (!overlaps) {
+                break;
+            }
+        }
+        if (slot == users.size()) {
+            users.push_back({});
+            slotSizes.push_back(0);
+        }
+        users[slot].push_back(i);
+        slotSizes[slot] = std::max(slotSizes[slot], resource.byteSize);
+        resource.slot = slot;
+    }
+
+    // transients see the whole slot buffer, which may be larger than what they asked for
+    for (size_t slotSize : slotSizes) {
+        slots.push_back(Buffer(*this, slotSize));
+        report.allocatedBytes += slotSize;
+    }
+    for (unsigned int i : order) {
+        resources[i].buffer = slots[resources[i].slot];
+    }
+    report.memorySaved = report.transientBytes - report.allocatedBytes;
+}
+
+void Graph::compile()
+{
+    if (commandBuffer) {
+        throw ERROR_COMMAND;
+    }
+    alias();
+
+    // one barrier in front of every level but the first, nodes within a level are independent
+    commandBuffer = new CommandBuffer(*this);
+    commandBuffer->begin();
+    for (unsigned int level = 0; level < numLevels; level++) {
+        if (level) {
+            commandBuffer->barrier();
+        }
+        for (Node &node : nodes) {
+            if (node.level != level) {
+                continue;
+            }
+
+            if (node.program) {
+                std::vector<BufferView> buffers;
+                for (unsigned int buffer : node.buffers) {
+                    buffers.push_back(resources[buffer].buffer);
+                }
+                Arguments arguments(*node.program, buffers);
+                commandBuffer->bind(*node.program, arguments);
+                commandBuffer->dispatch(node.x, node.y, node.z);
+            } else {
+                commandBuffer->copy(resources[node.buffers[0]].buffer, resources[node.buffers[1]].buffer, node.byteSize,
+                                    node.srcOffset, node.dstOffset);
+            }
+        }
+    }
+    commandBuffer->end();
+
+    report.nodes = nodes.size();
+    report.levels = numLevels;
+    report.barriers = commandBuffer->getBarrierCount();
+    report.barriersRemoved = nodes.size() > report.barriers ? nodes.size() - report.barriers : 0;
+}
+
+Completion Graph::submit(unsigned int queueIndex)
+{
+    if (!commandBuffer) {
+        throw ERROR_COMMAND;
+    }
+    return Device::submit(*commandBuffer, queueIndex);
+}
+
+GraphReport Graph::getReport()
+{
+    return report;
+}
+
+void Graph::destroy()
+{
+    if (commandBuffer) {
+        commandBuffer->destroy();
+        delete commandBuffer;
+        commandBuffer = nullptr;
+    }
+    for (Buffer &slot : slots) {
+        slot.destroy();
+    }
+    slots.clear();
+}
+
+}
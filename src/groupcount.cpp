@@ -0,0 +1,69 @@
+#include "groupcount.h"
+#include "arguments.h"
+
+namespace vc {
+
+// shaders/groupcount.comp, assembled by hand so that it ships with the library
+static const uint32_t groupCountCode[] = {
+    0x07230203, 0x00010000, 0x00000000, 0x0000002f, 0x00000000, 0x00020011, 0x00000001, 0x0003000e,
+    0x00000000, 0x00000001, 0x0005000f, 0x00000005, 0x00000001, 0x6e69616d, 0x00000000, 0x00060010,
+    0x00000001, 0x00000011, 0x00000001, 0x00000001, 0x00000001, 0x00040047, 0x00000002, 0x00000006,
+    0x00000004, 0x00050048, 0x00000003, 0x00000000, 0x00000023, 0x00000000, 0x00030047, 0x00000003,
+    0x00000003, 0x00040047, 0x00000004, 0x00000022, 0x00000000, 0x00040047, 0x00000004, 0x00000021,
+    0x00000000, 0x00040047, 0x00000005, 0x00000022, 0x00000000, 0x00040047, 0x00000005, 0x00000021,
+    0x00000001, 0x00050048, 0x00000006, 0x00000000, 0x00000023, 0x00000000, 0x00050048, 0x00000006,
+    0x00000001, 0x00000023, 0x00000004, 0x00050048, 0x00000006, 0x00000002, 0x00000023, 0x00000008,
+    0x00050048, 0x00000006, 0x00000003, 0x00000023, 0x0000000c, 0x00030047, 0x00000006, 0x00000002,
+    0x00020013, 0x00000007, 0x00030021, 0x00000008, 0x00000007, 0x00020014, 0x00000009, 0x00040015,
+    0x0000000a, 0x00000020, 0x00000000, 0x00040015, 0x0000000b, 0x00000020, 0x00000001, 0x0003001d,
+    0x00000002, 0x0000000a, 0x0003001e, 0x00000003, 0x00000002, 0x00040020, 0x0000000c, 0x00000002,
+    0x00000003, 0x0006001e, 0x00000006, 0x0000000a, 0x0000000a, 0x0000000a, 0x0000000a, 0x00040020,
+    0x0000000d, 0x00000009, 0x00000006, 0x00040020, 0x0000000e, 0x00000009, 0x0000000a, 0x00040020,
+    0x0000000f, 0x00000002, 0x0000000a, 0x0004002b, 0x0000000b, 0x00000010, 0x00000000, 0x0004002b,
+    0x0000000b, 0x00000011, 0x00000001, 0x0004002b, 0x0000000b, 0x00000012, 0x00000002, 0x0004002b,
+    0x0000000b, 0x00000013, 0x00000003, 0x0004002b, 0x0000000a, 0x00000014, 0x00000000, 0x0004002b,
+    0x0000000a, 0x00000015, 0x00000001, 0x0004002b, 0x0000000a, 0x00000016, 0x00000002, 0x0004003b,
+    0x0000000c, 0x00000004, 0x00000002, 0x0004003b, 0x0000000c, 0x00000005, 0x00000002, 0x0004003b,
+    0x0000000d, 0x00000017, 0x00000009, 0x00050036, 0x00000007, 0x00000001, 0x00000000, 0x00000008,
+    0x000200f8, 0x00000018, 0x00050041, 0x0000000e, 0x00000019, 0x00000017, 0x00000010, 0x0004003d,
+    0x0000000a, 0x0000001a, 0x00000019, 0x00050041, 0x0000000e, 0x0000001b, 0x00000017, 0x00000011,
+    0x0004003d, 0x0000000a, 0x0000001c, 0x0000001b, 0x00050041, 0x0000000e, 0x0000001d, 0x00000017,
+    0x00000012, 0x0004003d, 0x0000000a, 0x0000001e, 0x0000001d, 0x00050041, 0x0000000e, 0x0000001f,
+    0x00000017, 0x00000013, 0x0004003d, 0x0000000a, 0x00000020, 0x0000001f, 0x00060041, 0x0000000f,
+    0x00000021, 0x00000004, 0x00000010, 0x0000001a, 0x0004003d, 0x0000000a, 0x00000022, 0x00000021,
+    0x00050086, 0x0000000a, 0x00000023, 0x00000022, 0x0000001e, 0x00050089, 0x0000000a, 0x00000024,
+    0x00000022, 0x0000001e, 0x000500ab, 0x00000009, 0x00000025, 0x00000024, 0x00000014, 0x000600a9,
+    0x0000000a, 0x00000026, 0x00000025, 0x00000015, 0x00000014, 0x00050080, 0x0000000a, 0x00000027,
+    0x00000023, 0x00000026, 0x000500b0, 0x00000009, 0x00000028, 0x00000027, 0x00000020, 0x000600a9,
+    0x0000000a, 0x00000029, 0x00000028, 0x00000027, 0x00000020, 0x00060041, 0x0000000f, 0x0000002a,
+    0x00000005, 0x00000010, 0x0000001c, 0x0003003e, 0x0000002a, 0x00000029, 0x00050080, 0x0000000a,
+    0x0000002b, 0x0000001c, 0x00000015, 0x00060041, 0x0000000f, 0x0000002c, 0x00000005, 0x00000010,
+    0x0000002b, 0x0003003e, 0x0000002c, 0x00000015, 0x00050080, 0x0000000a, 0x0000002d, 0x0000001c,
+    0x00000016, 0x00060041, 0x0000000f, 0x0000002e, 0x00000005, 0x00000010, 0x0000002d, 0x0003003e,
+    0x0000002e, 0x00000015, 0x000100fd, 0x00010038,
+};
+
+GroupCount::GroupCount(Device &device) : Program(device, groupCountCode, sizeof(groupCountCode), {BUFFER, BUFFER}, {}, 16)
+{
+    setAccess({READ, WRITE});
+}
+
+void GroupCount::enqueue(CommandBuffer &commandBuffer, VkBuffer count, VkDeviceSize countOffset,
+                         VkBuffer groups, VkDeviceSize groupsOffset, uint32_t localSize)
+{
+    if (countOffset % 4 || groupsOffset % 4 || !localSize) {
+        throw ERROR_COMMAND;
+    }
+
+    struct {
+        uint32_t countIndex, groupsIndex, localSize, maxGroups;
+    } pushConstants = {(uint32_t) (countOffset / 4), (uint32_t) (groupsOffset / 4), localSize,
+                       context->physicalDeviceProperties.limits.maxComputeWorkGroupCount[0]};
+
+    Arguments arguments(*this, {count, groups});
+    commandBuffer.bind(*this, arguments);
+    commandBuffer.pushConstants(pushConstants);
+    commandBuffer.dispatch();
+}
+
+}
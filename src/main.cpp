@@ -1,4 +1,5 @@
 #include "vc.h"
+#include "../shaders/comp.h"
 using namespace vc;
 
 #include <thread>
@@ -18,7 +19,8 @@ int main()
             Buffer buffer(device, sizeof(double) * 10240);
             buffer.fill(0);
 
-            Program program(device, "/home/alexhultman/libvc/shaders/comp.spv", {BUFFER});
+            // embedded by make embed, resources are reflected from the shader
+            Program program(device, comp_spv);
             Arguments args(program, {buffer});
 
             CommandBuffer commands(device, program, args);
@@ -42,6 +44,7 @@ int main()
             buffer.destroy();
             args.destroy();
             commands.destroy();
+            program.destroy();
             device.destroy();
 
             cout << "Scalar is: " << results[0] << endl;
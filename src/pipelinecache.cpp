@@ -0,0 +1,109 @@
+#include "pipelinecache.h"
+#include <fstream>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/stat.h>
+
+namespace vc {
+
+PipelineCache::PipelineCache(Device &device, const char *directory) : Device(device)
+{
+    std::vector<char> data;
+    if (directory) {
+        char name[128];
+        sprintf(name, "/vc_%04x_%04x_", context->physicalDeviceProperties.vendorID, context->physicalDeviceProperties.deviceID);
+        fileName = std::string(directory) + name;
+        for (int i = 0; i < VK_UUID_SIZE; i++) {
+            sprintf(name, "%02x", context->physicalDeviceProperties.pipelineCacheUUID[i]);
+            fileName += name;
+        }
+        fileName += ".cache";
+
+        std::ifstream fin(fileName.c_str(), std::ifstream::ate | std::ifstream::binary);
+        if (fin.good()) {
+            data.resize(fin.tellg());
+            fin.seekg(0, std::ifstream::beg);
+            fin.read(data.data(), data.size());
+        }
+
+        // a stale or foreign cache is dropped rather than handed to the driver
+        if (!fin.good() || !validate(data.data(), data.size())) {
+            data.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+    pipelineCacheCreateInfo.initialDataSize = data.size();
+    pipelineCacheCreateInfo.pInitialData = data.data();
+    if (VK_SUCCESS != vkCreatePipelineCache(this->device, &pipelineCacheCreateInfo, nullptr, &pipelineCache)) {
+        throw ERROR_SHADER;
+    }
+}
+
+bool PipelineCache::validate(const char *data, size_t byteLength)
+{
+    VkPipelineCacheHeaderVersionOne header;
+    if (byteLength < sizeof(header)) {
+        return false;
+    }
+
+    memcpy(&header, data, sizeof(header));
+    return header.headerSize >= sizeof(header) && header.headerSize <= byteLength
+        && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header.vendorID == context->physicalDeviceProperties.vendorID
+        && header.deviceID == context->physicalDeviceProperties.deviceID
+        && !memcmp(header.pipelineCacheUUID, context->physicalDeviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+}
+
+PipelineCache::operator VkPipelineCache()
+{
+    return pipelineCache;
+}
+
+void PipelineCache::save()
+{
+    if (fileName.empty()) {
+        return;
+    }
+
+    size_t byteLength;
+    if (VK_SUCCESS != vkGetPipelineCacheData(device, pipelineCache, &byteLength, nullptr)) {
+        throw ERROR_SHADER;
+    }
+
+    std::vector<char> data(byteLength);
+    if (VK_SUCCESS != vkGetPipelineCacheData(device, pipelineCache, &byteLength, data.data())) {
+        throw ERROR_SHADER;
+    }
+
+    // write to a file of our own next to the cache and rename it into place, so that workers
+    // sharing the directory never read or rename each other's partial files
+    std::string temporaryName = fileName + ".XXXXXX";
+    int fd = mkstemp(&temporaryName[0]);
+    if (fd == -1) {
+        return;
+    }
+    fchmod(fd, 0644);
+
+    FILE *file = fdopen(fd, "wb");
+    if (!file) {
+        close(fd);
+        remove(temporaryName.c_str());
+        return;
+    }
+    bool written = fwrite(data.data(), 1, byteLength, file) == byteLength;
+    if (fclose(file) || !written || rename(temporaryName.c_str(), fileName.c_str())) {
+        remove(temporaryName.c_str());
+    }
+}
+
+void PipelineCache::destroy()
+{
+    save();
+    vkDestroyPipelineCache(device, pipelineCache, nullptr);
+}
+
+}
@@ -0,0 +1,151 @@
+#include "primitives.h"
+#include "arguments.h"
+#include <algorithm>
+
+namespace vc {
+
+enum {
+    WORKGROUP_SIZE = 256,
+    TILE = 1024,
+    REDUCE_TILE = 2048,
+    RADIX = 16,
+    RADIX_BITS = 4
+};
+
+static const char *typeNames[] = {"u32", "i32", "f32", "f64"};
+
+static uint32_t tiles(uint32_t count, uint32_t tile)
+{
+    return (count + tile - 1) / tile;
+}
+
+Primitives::Primitives(Device &device, const char *shaderDirectory) : Device(device), shaderDirectory(shaderDirectory)
+{
+    // the subgroup scan copes with any subgroup size the driver picks, the reported one is only a hint
+    subgroups = hasSubgroupArithmetic();
+}
+
+size_t Primitives::elementSize(ElementType type)
+{
+    return type == F64 ? 8 : 4;
+}
+
+Program &Primitives::program(const char *kernel, ElementType type)
+{
+    if (type == F64 && !context->float64) {
+        throw ERROR_SHADER;
+    }
+
+    std::string fileName = shaderDirectory + "/" + kernel + "_" + typeNames[type] + (subgroups ? "_subgroup.spv" : ".spv");
+    std::map<std::string, Program *>::iterator it = programs.find(fileName);
+    if (it != programs.end()) {
+        return *it->second;
+    }
+
+    // every kernel has the same push constants, resources follow from its name
+    std::string name = kernel;
+    std::vector<Access> access;
+    if (name == "reduce") {
+        access = {READ, WRITE};
+    } else if (name == "scan") {
+        access = {READ, WRITE, WRITE};
+    } else if (name == "add") {
+        access = {READ_WRITE, READ};
+    } else if (name == "radix_histogram") {
+        access = {READ, WRITE};
+    } else {
+        access = {READ, READ, READ, WRITE, WRITE};
+    }
+
+    Program *program = new Program(*this, fileName.c_str(), std::vector<ResourceType>(access.size(), BUFFER), {}, sizeof(Parameters));
+    program->setAccess(access);
+    programs[fileName] = program;
+    return *program;
+}
+
+void Primitives::dispatch(CommandBuffer &commands, Program &program, std::vector<BufferView> buffers, Parameters parameters, uint32_t groups)
+{
+    // about 64 million elements per scan pass on devices at the minimum limit
+    if (groups > context->physicalDeviceProperties.limits.maxComputeWorkGroupCount[0]) {
+        throw ERROR_COMMAND;
+    }
+
+    Arguments arguments(program, buffers);
+    commands.bind(program, arguments);
+    commands.pushConstants(parameters);
+    commands.dispatch(groups);
+}
+
+void Primitives::reduce(CommandBuffer &commands, ElementType type, VkBuffer input, VkBuffer result, uint32_t count)
+{
+    // partial sums alternate between two scratch buffers until one workgroup is left
+    Program &reduce = program("reduce", type);
+    unsigned int level = 0;
+    do {
+        uint32_t groups = std::max<uint32_t>(tiles(count, REDUCE_TILE), 1);
+        VkBuffer output = groups == 1 ? result : commands.scratch(SCRATCH_REDUCE + level % 2, groups * elementSize(type));
+        dispatch(commands, reduce, {input, output}, {count, 0, groups, 0}, groups);
+        input = output;
+        count = groups;
+        level++;
+    } while (count > 1);
+}
+
+void Primitives::scan(CommandBuffer &commands, ElementType type, VkBuffer input, VkBuffer output, uint32_t count, bool inclusive, unsigned int level)
+{
+    uint32_t groups = std::max<uint32_t>(tiles(count, TILE), 1);
+    VkBuffer totals = commands.scratch(SCRATCH_SCAN + 2 * level, groups * elementSize(type));
+    dispatch(commands, program("scan", type), {input, output, totals}, {count, 0, groups, inclusive}, groups);
+
+    // the exclusive scan of the tile totals offsets every tile after the first
+    if (groups > 1) {
+        VkBuffer offsets = commands.scratch(SCRATCH_SCAN + 2 * level + 1, groups * elementSize(type));
+        scan(commands, type, totals, offsets, groups, false, level + 1);
+        dispatch(commands, program("add", type), {output, offsets}, {count, 0, groups, 0}, groups);
+    }
+}
+
+void Primitives::scan(CommandBuffer &commands, ElementType type, VkBuffer input, VkBuffer output, uint32_t count, bool inclusive)
+{
+    scan(commands, type, input, output, count, inclusive, 0);
+}
+
+void Primitives::compact(CommandBuffer &commands, ElementType type, VkBuffer input, VkBuffer flags,
+                         VkBuffer output, VkBuffer survivors, uint32_t count)
+{
+    VkBuffer positions = commands.scratch(SCRATCH_COMPACT, std::max<size_t>(count, 1) * sizeof(uint32_t));
+    scan(commands, U32, flags, positions, count, false, 0);
+    dispatch(commands, program("compact", type), {input, flags, positions, output, survivors},
+             {count, 0, 0, 0}, std::max<uint32_t>(tiles(count, WORKGROUP_SIZE), 1));
+}
+
+void Primitives::sort(CommandBuffer &commands, ElementType keyType, VkBuffer keys, VkBuffer values, uint32_t count)
+{
+    // least significant digit first, an even number of passes ends in keys and values again
+    uint32_t groups = std::max<uint32_t>(tiles(count, TILE), 1);
+    size_t keySize = elementSize(keyType);
+    VkBuffer keyBuffers[2] = {keys, commands.scratch(SCRATCH_SORT, std::max<size_t>(count, 1) * keySize)};
+    VkBuffer valueBuffers[2] = {values, commands.scratch(SCRATCH_SORT + 1, std::max<size_t>(count, 1) * sizeof(uint32_t))};
+    VkBuffer histogram = commands.scratch(SCRATCH_SORT + 2, RADIX * groups * sizeof(uint32_t));
+    VkBuffer offsets = commands.scratch(SCRATCH_SORT + 3, RADIX * groups * sizeof(uint32_t));
+
+    Program &histogramProgram = program("radix_histogram", keyType);
+    Program &scatterProgram = program("radix_scatter", keyType);
+    for (uint32_t shift = 0, pass = 0; shift < keySize * 8; shift += RADIX_BITS, pass++) {
+        VkBuffer keysIn = keyBuffers[pass % 2], valuesIn = valueBuffers[pass % 2];
+        dispatch(commands, histogramProgram, {keysIn, histogram}, {count, shift, groups, 0}, groups);
+        scan(commands, U32, histogram, offsets, RADIX * groups, false, 0);
+        dispatch(commands, scatterProgram, {keysIn, valuesIn, offsets, keyBuffers[(pass + 1) % 2], valueBuffers[(pass + 1) % 2]},
+                 {count, shift, groups, 0}, groups);
+    }
+}
+
+void Primitives::destroy()
+{
+    for (std::pair<const std::string, Program *> &program : programs) {
+        delete program.second;
+    }
+    programs.clear();
+}
+
+}
@@ -0,0 +1,188 @@
+#include "profiler.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace vc {
+
+Profiler::Profiler(Device &device, uint32_t maxMarkers) : Device(device), capacity(maxMarkers * 2)
+{
+    uint32_t numQueues;
+    vkGetPhysicalDeviceQueueFamilyProperties(context->physicalDevice, &numQueues, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilyProperties(numQueues);
+    vkGetPhysicalDeviceQueueFamilyProperties(context->physicalDevice, &numQueues, queueFamilyProperties.data());
+
+    uint32_t validBits = queueFamilyProperties[context->computeQueueFamily].timestampValidBits;
+    if (!validBits) {
+        throw ERROR_DEVICES;
+    }
+    validMask = validBits == 64 ? ~0ULL : (1ULL << validBits) - 1;
+
+    VkQueryPoolCreateInfo queryPoolCreateInfo = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+    queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolCreateInfo.queryCount = capacity;
+    if (VK_SUCCESS != vkCreateQueryPool(this->device, &queryPoolCreateInfo, nullptr, &queryPool)) {
+        throw ERROR_DEVICES;
+    }
+}
+
+void Profiler::restart()
+{
+    used = 0;
+    needsReset = true;
+    markers.clear();
+    scopes.clear();
+    dispatches = 0;
+}
+
+uint32_t Profiler::write(VkCommandBuffer commandBuffer, VkPipelineStageFlags stage, const std::string &name)
+{
+    // queries are reset at the start of every execution of the recording
+    if (needsReset) {
+        vkCmdResetQueryPool(commandBuffer, queryPool, 0, capacity);
+        needsReset = false;
+    }
+
+    // markers past the capacity are dropped rather than failing the recording
+    if (used + 2 > capacity) {
+        return ~0U;
+    }
+
+    markers.push_back({name, used});
+    vkCmdWriteTimestamp(commandBuffer, stage, queryPool, used);
+    used += 2;
+    return markers.back().query;
+}
+
+void Profiler::beginScope(VkCommandBuffer commandBuffer, const char *name)
+{
+    scopes.push_back({name, write(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, name)});
+}
+
+void Profiler::endScope(VkCommandBuffer commandBuffer)
+{
+    if (scopes.empty()) {
+        throw ERROR_COMMAND;
+    }
+
+    uint32_t query = scopes.back().query;
+    scopes.pop_back();
+    if (query != ~0U) {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, query + 1);
+    }
+}
+
+void Profiler::beginDispatch(VkCommandBuffer commandBuffer)
+{
+    // dispatches are named after the scope they are recorded in and their position in the recording
+    std::string name = (scopes.size() ? scopes.back().name + "/dispatch " : "dispatch ") + std::to_string(dispatches++);
+    dispatchQuery = write(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, name);
+}
+
+void Profiler::endDispatch(VkCommandBuffer commandBuffer)
+{
+    if (dispatchQuery != ~0U) {
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, dispatchQuery + 1);
+    }
+}
+
+void Profiler::end()
+{
+    // a scope left open would never write its second timestamp
+    if (scopes.size()) {
+        throw ERROR_COMMAND;
+    }
+}
+
+void Profiler::collect()
+{
+    if (markers.empty()) {
+        return;
+    }
+
+    // every timestamp next to its availability, a recording that has not completed is an error
+    // rather than a wait that may never end
+    std::vector<uint64_t> results(used * 2);
+    VkResult result = vkGetQueryPoolResults(device, queryPool, 0, used, results.size() * sizeof(uint64_t), results.data(),
+                                            2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if (result != VK_SUCCESS && result != VK_NOT_READY) {
+        throw ERROR_DEVICES;
+    }
+
+    std::vector<uint64_t> timestamps(used);
+    for (Marker &marker : markers) {
+        for (uint32_t query = marker.query; query < marker.query + 2; query++) {
+            if (!results[query * 2 + 1]) {
+                throw ERROR_COMMAND;
+            }
+            timestamps[query] = results[query * 2];
+        }
+    }
+
+    // ticks to microseconds, relative to the first marker of the execution
+    double period = context->physicalDeviceProperties.limits.timestampPeriod / 1000.0;
+    uint64_t origin = timestamps[markers[0].query];
+    events.clear();
+    for (Marker &marker : markers) {
+        double start = ((timestamps[marker.query] - origin) & validMask) * period;
+        double duration = ((timestamps[marker.query + 1] - timestamps[marker.query]) & validMask) * period;
+        events.push_back({marker.name, start, duration});
+
+        std::map<std::string, size_t>::iterator index = statisticsIndex.find(marker.name);
+        if (index == statisticsIndex.end()) {
+            index = statisticsIndex.insert({marker.name, statistics.size()}).first;
+            statistics.push_back({marker.name, Statistics()});
+        }
+        Statistics &entry = statistics[index->second].second;
+        entry.min = entry.count ? std::min(entry.min, duration) : duration;
+        entry.max = entry.count ? std::max(entry.max, duration) : duration;
+        entry.total += duration;
+        entry.count++;
+    }
+}
+
+std::vector<ProfileEntry> Profiler::report()
+{
+    std::vector<ProfileEntry> entries;
+    for (std::pair<std::string, Statistics> &entry : statistics) {
+        entries.push_back({entry.first, entry.second.count, entry.second.min,
+                           entry.second.total / entry.second.count, entry.second.max});
+    }
+    return entries;
+}
+
+static std::string escape(const std::string &name)
+{
+    // scope names are user strings, JSON needs quotes, backslashes and control characters escaped
+    std::string escaped;
+    for (char c : name) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if ((unsigned char) c < 0x20) {
+            char code[8];
+            snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+void Profiler::exportChromeTrace(std::ostream &out)
+{
+    // complete events ("ph": "X") of the last collected execution, loadable in chrome://tracing
+    out << "{\"traceEvents\":[";
+    for (size_t i = 0; i < events.size(); i++) {
+        out << (i ? "," : "") << "\n{\"name\":\"" << escape(events[i].name) << "\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":"
+            << events[i].start << ",\"dur\":" << events[i].duration << "}";
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+void Profiler::destroy()
+{
+    vkDestroyQueryPool(device, queryPool, nullptr);
+}
+
+}
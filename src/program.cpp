@@ -1,19 +1,81 @@
 #include "program.h"
+#include "descriptorallocator.h"
+#include "pipelinecache.h"
+#include "reflection.h"
+#include <algorithm>
 
 namespace vc {
 
-Program::Program(Device &device, const char *fileName, std::vector<ResourceType> resourceTypes) : Device(device)
+std::vector<uint32_t> Program::readFile(const char *fileName)
 {
-    std::ifstream fin(fileName, std::ifstream::ate);
+    std::ifstream fin(fileName, std::ifstream::binary | std::ifstream::ate);
+    if (!fin) {
+        throw ERROR_SHADER;
+    }
     size_t byteLength = fin.tellg();
+    if (byteLength % 4) {
+        throw ERROR_SHADER;
+    }
     fin.seekg(0, std::ifstream::beg);
-    char *data = new char[byteLength];
-    fin.read(data, byteLength);
-    fin.close();
+    std::vector<uint32_t> code(byteLength / 4);
+    fin.read((char *) code.data(), byteLength);
+    return code;
+}
+
+Program::Program(Device &device, const char *fileName, std::vector<ResourceType> resourceTypes,
+                 std::vector<SpecializationConstant> specializationConstants, uint32_t pushConstantSize)
+    : Device(device), pushConstantSize(pushConstantSize)
+{
+    std::vector<uint32_t> code = readFile(fileName);
+    sharedConstructor(code.data(), code.size() * 4, &resourceTypes, specializationConstants);
+}
+
+Program::Program(Device &device, const uint32_t *code, size_t byteSize, std::vector<ResourceType> resourceTypes,
+                 std::vector<SpecializationConstant> specializationConstants, uint32_t pushConstantSize)
+    : Device(device), pushConstantSize(pushConstantSize)
+{
+    sharedConstructor(code, byteSize, &resourceTypes, specializationConstants);
+}
+
+Program::Program(Device &device, const char *fileName) : Device(device), pushConstantSize(0)
+{
+    std::vector<uint32_t> code = readFile(fileName);
+    std::vector<SpecializationConstant> specializationConstants;
+    sharedConstructor(code.data(), code.size() * 4, nullptr, specializationConstants);
+}
+
+Program::Program(Device &device, const uint32_t *code, size_t byteSize) : Device(device), pushConstantSize(0)
+{
+    std::vector<SpecializationConstant> specializationConstants;
+    sharedConstructor(code, byteSize, nullptr, specializationConstants);
+}
+
+void Program::sharedConstructor(const uint32_t *code, size_t byteSize, std::vector<ResourceType> *declaredResourceTypes,
+                                std::vector<SpecializationConstant> &specializationConstants)
+{
+    // what the shader declares has to match what the caller declared, if anything
+    // the shader can't tell dynamic buffers apart, so any buffer may be declared dynamic
+    Reflection reflection(code, byteSize);
+    resourceTypes = reflection.resourceTypes;
+    if (declaredResourceTypes) {
+        if (declaredResourceTypes->size() != resourceTypes.size() || pushConstantSize < reflection.pushConstantSize) {
+            throw ERROR_SHADER;
+        }
+        for (size_t i = 0; i < resourceTypes.size(); i++) {
+            if ((*declaredResourceTypes)[i] != resourceTypes[i] && !((*declaredResourceTypes)[i] == BUFFER_DYNAMIC && resourceTypes[i] == BUFFER)) {
+                throw ERROR_SHADER;
+            }
+        }
+        resourceTypes = *declaredResourceTypes;
+    } else {
+        pushConstantSize = reflection.pushConstantSize;
+    }
+    access = reflection.access;
+    std::copy(reflection.localSize, reflection.localSize + 3, localSize);
 
     VkShaderModuleCreateInfo shaderModuleCreateInfo = {VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
-    shaderModuleCreateInfo.codeSize = byteLength;
-    shaderModuleCreateInfo.pCode = (uint32_t *) data;
+    shaderModuleCreateInfo.codeSize = byteSize;
+    shaderModuleCreateInfo.pCode = code;
     if (VK_SUCCESS != vkCreateShaderModule(this->device, &shaderModuleCreateInfo, nullptr, &shaderModule)) {
         throw ERROR_SHADER;
     }
@@ -37,24 +99,85 @@ Program::Program(Device &device, const char *fileName, std::vector<ResourceType>
     VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
     pipelineLayoutCreateInfo.setLayoutCount = 1;
     pipelineLayoutCreateInfo.pSetLayouts = &descriptorSetLayout;
+
+    // one range covering every push constant of the compute stage
+    VkPushConstantRange pushConstantRange = {VK_SHADER_STAGE_COMPUTE_BIT, 0, pushConstantSize};
+    if (pushConstantSize) {
+        if (pushConstantSize > context->physicalDeviceProperties.limits.maxPushConstantsSize || pushConstantSize % 4) {
+            throw ERROR_SHADER;
+        }
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+    }
     if (VK_SUCCESS != vkCreatePipelineLayout(this->device,&pipelineLayoutCreateInfo, nullptr, &pipelineLayout)) {
         throw ERROR_SHADER;
     }
 
     delete [] bindings;
-    delete [] data;
+
+    variants = new Variants;
+    variants->references = 1;
+    pipeline = createPipeline(specializationConstants);
+}
+
+VkPipeline Program::createPipeline(std::vector<SpecializationConstant> &specializationConstants)
+{
+    std::sort(specializationConstants.begin(), specializationConstants.end(), [](const SpecializationConstant &a, const SpecializationConstant &b) {
+        return a.id < b.id;
+    });
+
+    std::vector<uint32_t> key;
+    std::vector<VkSpecializationMapEntry> mapEntries;
+    for (SpecializationConstant &constant : specializationConstants) {
+        mapEntries.push_back({constant.id, (uint32_t) (key.size() / 2 * sizeof(uint32_t)), sizeof(uint32_t)});
+        key.push_back(constant.id);
+        key.push_back(constant.value);
+    }
+
+    std::unique_lock<std::mutex> lock(variants->mutex);
+    std::map<std::vector<uint32_t>, VkPipeline>::iterator variant = variants->pipelines.find(key);
+    if (variant != variants->pipelines.end()) {
+        return variant->second;
+    }
+
+    std::vector<uint32_t> data;
+    for (SpecializationConstant &constant : specializationConstants) {
+        data.push_back(constant.value);
+    }
+
+    VkSpecializationInfo specializationInfo = {};
+    specializationInfo.mapEntryCount = mapEntries.size();
+    specializationInfo.pMapEntries = mapEntries.data();
+    specializationInfo.dataSize = data.size() * sizeof(uint32_t);
+    specializationInfo.pData = data.data();
 
     VkPipelineShaderStageCreateInfo pipelineShaderInfo = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
     pipelineShaderInfo.module = shaderModule;
     pipelineShaderInfo.pName = "main";
     pipelineShaderInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipelineShaderInfo.pSpecializationInfo = &specializationInfo;
 
     VkComputePipelineCreateInfo pipelineInfo = {VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
     pipelineInfo.stage = pipelineShaderInfo;
     pipelineInfo.layout = pipelineLayout;
-    if (VK_SUCCESS != vkCreateComputePipelines(this->device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline)) {
+
+    VkPipeline pipeline;
+    if (VK_SUCCESS != vkCreateComputePipelines(this->device, *context->pipelineCache, 1, &pipelineInfo, nullptr, &pipeline)) {
         throw ERROR_DEVICES;
     }
+    variants->pipelines[key] = pipeline;
+    return pipeline;
+}
+
+Program Program::specialize(std::vector<SpecializationConstant> specializationConstants)
+{
+    // shares module, layouts and variants with this program
+    VkPipeline pipeline = createPipeline(specializationConstants);
+    Program program(*this);
+    program.pipeline = pipeline;
+    std::unique_lock<std::mutex> lock(variants->mutex);
+    variants->references++;
+    return program;
 }
 
 void Program::bindTo(VkCommandBuffer commandBuffer)
@@ -62,4 +185,69 @@ void Program::bindTo(VkCommandBuffer commandBuffer)
     vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
 }
 
+void Program::setAccess(std::vector<Access> access)
+{
+    if (access.size() != this->access.size()) {
+        throw ERROR_SHADER;
+    }
+    this->access = access;
+}
+
+uint32_t Program::getLocalSize(unsigned int dimension)
+{
+    return dimension < 3 ? localSize[dimension] : 1;
+}
+
+Program::Program(Program &&program) noexcept : Program(program)
+{
+    program.variants = nullptr;
+}
+
+Program &Program::operator=(Program &&program) noexcept
+{
+    if (this != &program) {
+        destroy();
+        Device::operator=(program);
+        variants = program.variants;
+        shaderModule = program.shaderModule;
+        pipelineLayout = program.pipelineLayout;
+        descriptorSetLayout = program.descriptorSetLayout;
+        pipeline = program.pipeline;
+        pushConstantSize = program.pushConstantSize;
+        access = std::move(program.access);
+        resourceTypes = std::move(program.resourceTypes);
+        std::copy(program.localSize, program.localSize + 3, localSize);
+        program.variants = nullptr;
+    }
+    return *this;
+}
+
+Program::~Program()
+{
+    destroy();
+}
+
+void Program::destroy()
+{
+    if (!variants) {
+        return;
+    }
+
+    // specializations still in use keep the module, layouts and every pipeline alive
+    std::unique_lock<std::mutex> lock(variants->mutex);
+    bool last = !--variants->references;
+    lock.unlock();
+    if (last) {
+        for (std::pair<const std::vector<uint32_t>, VkPipeline> &variant : variants->pipelines) {
+            vkDestroyPipeline(device, variant.second, nullptr);
+        }
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+        context->descriptorAllocator->evictLayout(descriptorSetLayout);
+        vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
+        vkDestroyShaderModule(device, shaderModule, nullptr);
+        delete variants;
+    }
+    variants = nullptr;
+}
+
 }
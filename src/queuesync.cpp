@@ -0,0 +1,243 @@
+#include "queuesync.h"
+#include "fencepool.h"
+
+namespace vc {
+
+QueueSync::QueueSync(Device &device) : Device(device)
+{
+    if (!context->timelineWait) {
+        return;
+    }
+
+    VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO};
+    semaphoreTypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    VkSemaphoreCreateInfo semaphoreCreateInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+    semaphoreCreateInfo.pNext = &semaphoreTypeCreateInfo;
+    for (unsigned int i = 0; i < context->numComputeQueues; i++) {
+        if (VK_SUCCESS != vkCreateSemaphore(this->device, &semaphoreCreateInfo, nullptr, &timelines[i])) {
+            throw ERROR_DEVICES;
+        }
+    }
+}
+
+bool QueueSync::linked(unsigned int queueIndex)
+{
+    return context->computeQueues[queueIndex] != context->transferQueue;
+}
+
+VkSemaphore QueueSync::acquire()
+{
+    // semaphores can be reused once the submission waiting on them has completed
+    for (size_t i = 0; i < usedSemaphores.size(); ) {
+        if (usedSemaphores[i].completion.poll()) {
+            freeSemaphores.push_back(usedSemaphores[i].semaphore);
+            usedSemaphores[i] = usedSemaphores.back();
+            usedSemaphores.pop_back();
+        } else {
+            i++;
+        }
+    }
+
+    if (freeSemaphores.size()) {
+        VkSemaphore semaphore = freeSemaphores.back();
+        freeSemaphores.pop_back();
+        return semaphore;
+    }
+
+    VkSemaphore semaphore;
+    VkSemaphoreCreateInfo semaphoreCreateInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+    if (VK_SUCCESS != vkCreateSemaphore(device, &semaphoreCreateInfo, nullptr, &semaphore)) {
+        throw ERROR_DEVICES;
+    }
+    return semaphore;
+}
+
+Completion QueueSync::computeSubmit(unsigned int queueIndex, VkSubmitInfo submitInfo,
+                                    const std::vector<SyncPoint> &after, SyncPoint *point)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // wait for every transfer submitted since the last submission to this queue
+    std::vector<VkSemaphore> waitSemaphores;
+    for (Signal &signal : pendingWaits[queueIndex]) {
+        waitSemaphores.push_back(signal.semaphore);
+    }
+    pendingWaits[queueIndex].clear();
+    size_t binaryWaits = waitSemaphores.size();
+
+    // values are ignored for the binary semaphores in front
+    std::vector<uint64_t> waitValues(binaryWaits, 0);
+    for (const SyncPoint &waitPoint : after) {
+        waitSemaphores.push_back(waitPoint.semaphore);
+        waitValues.push_back(waitPoint.value);
+    }
+
+    std::vector<VkPipelineStageFlags> waitStages(waitSemaphores.size(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    submitInfo.waitSemaphoreCount = waitSemaphores.size();
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
+
+    // values are handed out under the lock, so they increase in submission order
+    VkTimelineSemaphoreSubmitInfo timelineSemaphoreSubmitInfo = {VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+    uint64_t signalValue = timelineValues[queueIndex] + 1;
+    if (timelines[queueIndex]) {
+        timelineSemaphoreSubmitInfo.pNext = submitInfo.pNext;
+        timelineSemaphoreSubmitInfo.waitSemaphoreValueCount = waitValues.size();
+        timelineSemaphoreSubmitInfo.pWaitSemaphoreValues = waitValues.data();
+        timelineSemaphoreSubmitInfo.signalSemaphoreValueCount = 1;
+        timelineSemaphoreSubmitInfo.pSignalSemaphoreValues = &signalValue;
+        submitInfo.pNext = &timelineSemaphoreSubmitInfo;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &timelines[queueIndex];
+    } else if (after.size()) {
+        throw ERROR_DEVICES;
+    }
+    Completion completion = context->fencePool->submit(context->computeQueues[queueIndex], 1, &submitInfo);
+
+    if (timelines[queueIndex]) {
+        timelineValues[queueIndex] = signalValue;
+    }
+    if (point) {
+        *point = {timelines[queueIndex], signalValue};
+    }
+
+    for (size_t i = 0; i < binaryWaits; i++) {
+        usedSemaphores.push_back({waitSemaphores[i], completion});
+    }
+    dirty[queueIndex] = linked(queueIndex);
+    return completion;
+}
+
+Completion QueueSync::batchSubmit(unsigned int queueIndex, const std::vector<VkCommandBuffer> &commandBuffers)
+{
+    BatchEntry entry = {&commandBuffers, Completion(), false, false};
+    std::unique_lock<std::mutex> lock(batchMutex);
+    batches[queueIndex].push_back(&entry);
+
+    // whoever finds no submission in progress submits everything queued up by then,
+    // in one batch sharing one fence. The others wait for it to return
+    while (!entry.done) {
+        if (submitting[queueIndex]) {
+            batchCondition.wait(lock);
+            continue;
+        }
+
+        std::vector<BatchEntry *> batch;
+        batch.swap(batches[queueIndex]);
+        submitting[queueIndex] = true;
+        lock.unlock();
+
+        std::vector<VkCommandBuffer> batchedCommandBuffers;
+        for (BatchEntry *batched : batch) {
+            batchedCommandBuffers.insert(batchedCommandBuffers.end(), batched->commandBuffers->begin(), batched->commandBuffers->end());
+        }
+
+        VkSubmitInfo submitInfo = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+        submitInfo.commandBufferCount = batchedCommandBuffers.size();
+        submitInfo.pCommandBuffers = batchedCommandBuffers.data();
+        Completion completion;
+        bool failed = false;
+        try {
+            completion = computeSubmit(queueIndex, submitInfo);
+        } catch (Error) {
+            failed = true;
+        }
+
+        lock.lock();
+        for (BatchEntry *batched : batch) {
+            batched->completion = completion;
+            batched->failed = failed;
+            batched->done = true;
+        }
+        submitting[queueIndex] = false;
+        batchCondition.notify_all();
+    }
+
+    if (entry.failed) {
+        throw ERROR_DEVICES;
+    }
+    return entry.completion;
+}
+
+Completion QueueSync::transferSubmit(VkSubmitInfo submitInfo, bool afterCompute)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // compute queues with work since the last download signal a semaphore from an empty batch,
+    // submitted through the fence pool like everything else so the queue is never used concurrently
+    std::vector<VkSemaphore> waitSemaphores;
+    if (afterCompute) {
+        for (unsigned int i = 0; i < context->numComputeQueues; i++) {
+            if (dirty[i]) {
+                VkSemaphore semaphore = acquire();
+                VkSubmitInfo signalInfo = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+                signalInfo.signalSemaphoreCount = 1;
+                signalInfo.pSignalSemaphores = &semaphore;
+                context->fencePool->submit(context->computeQueues[i], 1, &signalInfo);
+                waitSemaphores.push_back(semaphore);
+                dirty[i] = false;
+            }
+        }
+    }
+
+    std::vector<VkSemaphore> signalSemaphores;
+    for (unsigned int i = 0; i < context->numComputeQueues; i++) {
+        if (linked(i)) {
+            signalSemaphores.push_back(acquire());
+        }
+    }
+
+    std::vector<VkPipelineStageFlags> waitStages(waitSemaphores.size(), VK_PIPELINE_STAGE_TRANSFER_BIT);
+    submitInfo.waitSemaphoreCount = waitSemaphores.size();
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
+    submitInfo.signalSemaphoreCount = signalSemaphores.size();
+    submitInfo.pSignalSemaphores = signalSemaphores.data();
+    Completion completion = context->fencePool->submit(context->transferQueue, 1, &submitInfo);
+
+    for (VkSemaphore semaphore : waitSemaphores) {
+        usedSemaphores.push_back({semaphore, completion});
+    }
+
+    // the transfer queue runs in order, so a completed older signal nobody waited on
+    // yet is implied by this one and can be dropped
+    std::vector<VkSemaphore>::iterator signal = signalSemaphores.begin();
+    for (unsigned int i = 0; i < context->numComputeQueues; i++) {
+        if (linked(i)) {
+            std::vector<Signal> &waits = pendingWaits[i];
+            for (size_t j = 0; j < waits.size(); ) {
+                if (waits[j].completion.poll()) {
+                    vkDestroySemaphore(device, waits[j].semaphore, nullptr);
+                    waits.erase(waits.begin() + j);
+                } else {
+                    j++;
+                }
+            }
+            waits.push_back({*signal++, completion});
+        }
+    }
+    return completion;
+}
+
+void QueueSync::destroy()
+{
+    vkDeviceWaitIdle(device);
+    for (VkSemaphore semaphore : freeSemaphores) {
+        vkDestroySemaphore(device, semaphore, nullptr);
+    }
+
+    for (Signal &signal : usedSemaphores) {
+        vkDestroySemaphore(device, signal.semaphore, nullptr);
+    }
+
+    for (unsigned int i = 0; i < context->numComputeQueues; i++) {
+        for (Signal &signal : pendingWaits[i]) {
+            vkDestroySemaphore(device, signal.semaphore, nullptr);
+        }
+        if (timelines[i]) {
+            vkDestroySemaphore(device, timelines[i], nullptr);
+        }
+    }
+}
+
+}
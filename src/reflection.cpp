@@ -0,0 +1,259 @@
+#include "reflection.h"
+#include <map>
+#include <algorithm>
+
+namespace vc {
+
+enum {
+    SPIRV_MAGIC = 0x07230203,
+
+    // opcodes
+    OP_EXECUTION_MODE = 16,
+    OP_TYPE_INT = 21,
+    OP_TYPE_FLOAT = 22,
+    OP_TYPE_VECTOR = 23,
+    OP_TYPE_MATRIX = 24,
+    OP_TYPE_ARRAY = 28,
+    OP_TYPE_RUNTIME_ARRAY = 29,
+    OP_TYPE_STRUCT = 30,
+    OP_TYPE_POINTER = 32,
+    OP_CONSTANT = 43,
+    OP_CONSTANT_COMPOSITE = 44,
+    OP_SPEC_CONSTANT = 50,
+    OP_SPEC_CONSTANT_COMPOSITE = 51,
+    OP_VARIABLE = 59,
+    OP_DECORATE = 71,
+    OP_MEMBER_DECORATE = 72,
+    OP_EXECUTION_MODE_ID = 331,
+
+    // decorations
+    DECORATION_SPEC_ID = 1,
+    DECORATION_BLOCK = 2,
+    DECORATION_BUFFER_BLOCK = 3,
+    DECORATION_ARRAY_STRIDE = 6,
+    DECORATION_MATRIX_STRIDE = 7,
+    DECORATION_BUILT_IN = 11,
+    DECORATION_NON_WRITABLE = 24,
+    DECORATION_NON_READABLE = 25,
+    DECORATION_BINDING = 33,
+    DECORATION_DESCRIPTOR_SET = 34,
+    DECORATION_OFFSET = 35,
+
+    // storage classes
+    STORAGE_UNIFORM_CONSTANT = 0,
+    STORAGE_UNIFORM = 2,
+    STORAGE_PUSH_CONSTANT = 9,
+    STORAGE_IMAGE = 11,
+    STORAGE_STORAGE_BUFFER = 12,
+
+    EXECUTION_MODE_LOCAL_SIZE = 17,
+    EXECUTION_MODE_LOCAL_SIZE_ID = 38,
+    BUILT_IN_WORKGROUP_SIZE = 25
+};
+
+namespace {
+
+// just the ids and instructions the layout depends on
+struct Module {
+    std::map<uint32_t, std::vector<uint32_t>> types, constants;
+    std::map<uint32_t, std::map<uint32_t, uint32_t>> decorations;
+    std::map<uint32_t, std::map<uint32_t, std::map<uint32_t, uint32_t>>> memberDecorations;
+
+    bool decorated(uint32_t id, uint32_t decoration)
+    {
+        return decorations.count(id) && decorations[id].count(decoration);
+    }
+
+    bool memberDecorated(uint32_t id, uint32_t member, uint32_t decoration)
+    {
+        return memberDecorations.count(id) && memberDecorations[id].count(member) && memberDecorations[id][member].count(decoration);
+    }
+
+    std::vector<uint32_t> &type(uint32_t id)
+    {
+        if (!types.count(id)) {
+            throw ERROR_SHADER;
+        }
+        return types[id];
+    }
+
+    uint32_t constant(uint32_t id)
+    {
+        if (!constants.count(id) || constants[id].size() < 1) {
+            throw ERROR_SHADER;
+        }
+        return constants[id][0];
+    }
+
+    // bytes a type takes in an explicitly laid out block, runtime arrays count as empty
+    uint32_t size(uint32_t id)
+    {
+        std::vector<uint32_t> &instruction = type(id);
+        switch (instruction[0]) {
+        case OP_TYPE_INT:
+        case OP_TYPE_FLOAT:
+            return instruction[2] / 8;
+        case OP_TYPE_VECTOR:
+            return size(instruction[2]) * instruction[3];
+        case OP_TYPE_MATRIX:
+            return (decorated(id, DECORATION_MATRIX_STRIDE) ? decorations[id][DECORATION_MATRIX_STRIDE] : size(instruction[2])) * instruction[3];
+        case OP_TYPE_ARRAY:
+            return (decorated(id, DECORATION_ARRAY_STRIDE) ? decorations[id][DECORATION_ARRAY_STRIDE] : size(instruction[2])) * constant(instruction[3]);
+        case OP_TYPE_RUNTIME_ARRAY:
+            return 0;
+        case OP_TYPE_STRUCT: {
+            uint32_t end = 0;
+            for (uint32_t member = 0; member + 2 < instruction.size(); member++) {
+                uint32_t offset = memberDecorated(id, member, DECORATION_OFFSET) ? memberDecorations[id][member][DECORATION_OFFSET] : end;
+                end = std::max(end, offset + size(instruction[member + 2]));
+            }
+            return end;
+        }
+        default:
+            throw ERROR_SHADER;
+        }
+    }
+
+    // a decoration on the block itself or on every one of its members
+    bool blockDecorated(uint32_t id, uint32_t decoration)
+    {
+        std::vector<uint32_t> &instruction = type(id);
+        if (decorated(id, decoration)) {
+            return true;
+        }
+        for (uint32_t member = 0; member + 2 < instruction.size(); member++) {
+            if (!memberDecorated(id, member, decoration)) {
+                return false;
+            }
+        }
+        return instruction.size() > 2;
+    }
+};
+
+}
+
+Reflection::Reflection(const uint32_t *code, size_t byteSize) : pushConstantSize(0), localSize{1, 1, 1}, localSizeIds{-1, -1, -1}
+{
+    size_t numWords = byteSize / 4;
+    if (byteSize % 4 || numWords < 5 || code[0] != SPIRV_MAGIC) {
+        throw ERROR_SHADER;
+    }
+
+    // every instruction is (word count << 16 | opcode) followed by its operands. Types are
+    // kept as [opcode, result id, operands...], constants as their values only
+    Module module;
+    std::vector<std::pair<uint32_t, uint32_t>> variables;
+    std::vector<uint32_t> localSizeConstants;
+    for (size_t i = 5; i < numWords; ) {
+        uint32_t opcode = code[i] & 0xffff, wordCount = code[i] >> 16;
+        if (!wordCount || i + wordCount > numWords) {
+            throw ERROR_SHADER;
+        }
+        const uint32_t *operands = code + i + 1;
+
+        switch (opcode) {
+        case OP_EXECUTION_MODE:
+            if (wordCount >= 6 && operands[1] == EXECUTION_MODE_LOCAL_SIZE) {
+                std::copy(operands + 2, operands + 5, localSize);
+            }
+            break;
+        case OP_EXECUTION_MODE_ID:
+            // LocalSizeId names constants, which are only declared further down
+            if (wordCount >= 6 && operands[1] == EXECUTION_MODE_LOCAL_SIZE_ID) {
+                localSizeConstants.assign(operands + 2, operands + 5);
+            }
+            break;
+        case OP_TYPE_INT:
+        case OP_TYPE_FLOAT:
+        case OP_TYPE_VECTOR:
+        case OP_TYPE_MATRIX:
+        case OP_TYPE_ARRAY:
+        case OP_TYPE_RUNTIME_ARRAY:
+        case OP_TYPE_STRUCT:
+        case OP_TYPE_POINTER: {
+            std::vector<uint32_t> &type = module.types[operands[0]];
+            type.push_back(opcode);
+            type.push_back(operands[0]);
+            type.insert(type.end(), operands + 1, operands + wordCount - 1);
+            break;
+        }
+        case OP_CONSTANT:
+        case OP_SPEC_CONSTANT:
+        case OP_CONSTANT_COMPOSITE:
+        case OP_SPEC_CONSTANT_COMPOSITE:
+            if (wordCount >= 4) {
+                module.constants[operands[1]].assign(operands + 2, operands + wordCount - 1);
+            }
+            break;
+        case OP_VARIABLE:
+            if (wordCount >= 4) {
+                variables.push_back({operands[0], operands[1]});
+            }
+            break;
+        case OP_DECORATE:
+            if (wordCount >= 3) {
+                module.decorations[operands[0]][operands[1]] = wordCount >= 4 ? operands[2] : 0;
+                if (operands[1] == DECORATION_BUILT_IN && wordCount >= 4 && operands[2] == BUILT_IN_WORKGROUP_SIZE) {
+                    localSizeConstants.assign(1, operands[0]);
+                }
+            }
+            break;
+        case OP_MEMBER_DECORATE:
+            if (wordCount >= 4) {
+                module.memberDecorations[operands[0]][operands[1]][operands[2]] = wordCount >= 5 ? operands[3] : 0;
+            }
+            break;
+        }
+        i += wordCount;
+    }
+
+    // the WorkgroupSize built-in overrides the execution mode, both may name spec constants
+    if (localSizeConstants.size() == 1) {
+        std::vector<uint32_t> components = module.constants[localSizeConstants[0]];
+        localSizeConstants = components;
+    }
+    for (size_t i = 0; i < localSizeConstants.size() && i < 3; i++) {
+        localSize[i] = module.constant(localSizeConstants[i]);
+        if (module.decorated(localSizeConstants[i], DECORATION_SPEC_ID)) {
+            localSizeIds[i] = module.decorations[localSizeConstants[i]][DECORATION_SPEC_ID];
+        }
+    }
+
+    std::map<uint32_t, std::pair<ResourceType, Access>> bindings;
+    for (std::pair<uint32_t, uint32_t> &variable : variables) {
+        std::vector<uint32_t> &pointer = module.type(variable.first);
+        uint32_t storageClass = pointer[2], pointee = pointer[3];
+
+        if (storageClass == STORAGE_PUSH_CONSTANT) {
+            pushConstantSize = std::max(pushConstantSize, module.size(pointee));
+            continue;
+        }
+        if (storageClass != STORAGE_UNIFORM && storageClass != STORAGE_STORAGE_BUFFER &&
+            storageClass != STORAGE_UNIFORM_CONSTANT && storageClass != STORAGE_IMAGE) {
+            continue;
+        }
+
+        // storage buffers are BufferBlock in Uniform before SPIR-V 1.3, Block in StorageBuffer after
+        bool storageBuffer = (storageClass == STORAGE_UNIFORM && module.decorated(pointee, DECORATION_BUFFER_BLOCK)) ||
+                             (storageClass == STORAGE_STORAGE_BUFFER && module.decorated(pointee, DECORATION_BLOCK));
+        uint32_t set = module.decorated(variable.second, DECORATION_DESCRIPTOR_SET) ? module.decorations[variable.second][DECORATION_DESCRIPTOR_SET] : 0;
+        uint32_t binding = module.decorated(variable.second, DECORATION_BINDING) ? module.decorations[variable.second][DECORATION_BINDING] : 0;
+        if (!storageBuffer || set != 0 || bindings.count(binding)) {
+            throw ERROR_SHADER;
+        }
+
+        bool readOnly = module.decorated(variable.second, DECORATION_NON_WRITABLE) || module.blockDecorated(pointee, DECORATION_NON_WRITABLE);
+        bool writeOnly = module.decorated(variable.second, DECORATION_NON_READABLE) || module.blockDecorated(pointee, DECORATION_NON_READABLE);
+        bindings[binding] = {BUFFER, readOnly ? READ : (writeOnly ? WRITE : READ_WRITE)};
+    }
+
+    for (std::pair<const uint32_t, std::pair<ResourceType, Access>> &binding : bindings) {
+        if (binding.first != resourceTypes.size()) {
+            throw ERROR_SHADER;
+        }
+        resourceTypes.push_back(binding.second.first);
+        access.push_back(binding.second.second);
+    }
+}
+
+}
@@ -0,0 +1,210 @@
+#include "shardeddispatch.h"
+#include "buffer.h"
+#include "arguments.h"
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+
+namespace vc {
+
+ShardedDispatch::ShardedDispatch(DevicePool &devicePool, const char *fileName, std::vector<ResourceType> resourceTypes, unsigned int shardsPerDevice)
+{
+    for (Device &device : devicePool.getDevices()) {
+        Program *program = new Program(device, fileName, resourceTypes, {}, sizeof(FirstGroup));
+        programs.push_back(program);
+
+        // logical shards of one device spread over its compute queues
+        for (unsigned int i = 0; i < shardsPerDevice; i++) {
+            shards.push_back({device, program, i % device.getComputeQueueCount(), 1.0});
+        }
+    }
+    weighByProperties();
+}
+
+void ShardedDispatch::weighByProperties()
+{
+    for (Shard &shard : shards) {
+        switch (shard.device.getProperties().deviceType) {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:
+            shard.weight = 4.0;
+            break;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:
+            shard.weight = 2.0;
+            break;
+        default:
+            shard.weight = 1.0;
+            break;
+        }
+    }
+}
+
+std::vector<ShardedDispatch::Range> ShardedDispatch::split(size_t slices, size_t granularity)
+{
+    // hand out whole workgroups by weight, largest remainders get the leftovers
+    size_t groups = (slices + granularity - 1) / granularity;
+    double totalWeight = 0;
+    for (Shard &shard : shards) {
+        totalWeight += shard.weight;
+    }
+
+    std::vector<Range> ranges(shards.size());
+    std::vector<std::pair<double, size_t>> remainders;
+    size_t assigned = 0;
+    for (size_t i = 0; i < shards.size(); i++) {
+        double share = groups * shards[i].weight / totalWeight;
+        ranges[i].groups = (size_t) share;
+        remainders.push_back({share - ranges[i].groups, i});
+        assigned += ranges[i].groups;
+    }
+
+    std::sort(remainders.rbegin(), remainders.rend());
+    for (size_t i = 0; assigned < groups; i++, assigned++) {
+        ranges[remainders[i % remainders.size()].second].groups++;
+    }
+
+    size_t offset = 0;
+    for (Range &range : ranges) {
+        range.offset = offset;
+        range.slices = std::min(range.groups * granularity, slices - offset);
+        offset += range.slices;
+    }
+    return ranges;
+}
+
+std::vector<double> ShardedDispatch::run(size_t globalX, size_t globalY, std::vector<ShardedBuffer> &buffers, int localX, int localY)
+{
+    // 1D ranges are split along x, 2D ranges by rows
+    bool rows = globalY > 1;
+    std::vector<Range> ranges = split(rows ? globalY : globalX, rows ? localY : localX);
+    int groupsX = rows ? (globalX + localX - 1) / localX : 1;
+
+    // owned here, so that nothing leaks when a shard fails
+    struct Work {
+        std::vector<Buffer> buffers;
+        std::unique_ptr<Arguments> arguments;
+        std::unique_ptr<CommandBuffer> commands;
+        Completion completion;
+    };
+    std::vector<Work> work(shards.size());
+
+    // scatter inputs and start every shard before waiting on any of them. Each shard is timed
+    // from its own submission, not counting the uploads to the shards before it
+    std::vector<std::chrono::steady_clock::time_point> starts(shards.size());
+    try {
+        for (size_t i = 0; i < shards.size(); i++) {
+            if (!ranges[i].groups) {
+                continue;
+            }
+
+            size_t granularity = rows ? localY : localX;
+            for (ShardedBuffer &buffer : buffers) {
+                work[i].buffers.push_back(Buffer(shards[i].device, ranges[i].groups * granularity * buffer.bytesPerSlice));
+                if (buffer.input) {
+                    work[i].buffers.back().upload((char *) buffer.hostPtr + ranges[i].offset * buffer.bytesPerSlice,
+                                                  ranges[i].slices * buffer.bytesPerSlice);
+                }
+            }
+
+            // the shard's first workgroup within the whole range, for kernels indexing globally
+            FirstGroup firstGroup = {0, 0};
+            (rows ? firstGroup.y : firstGroup.x) = ranges[i].offset / granularity;
+
+            work[i].arguments.reset(new Arguments(*shards[i].program, std::vector<BufferView>(work[i].buffers.begin(), work[i].buffers.end())));
+            work[i].commands.reset(new CommandBuffer(shards[i].device, *shards[i].program, *work[i].arguments));
+            work[i].commands->pushConstants(firstGroup);
+            work[i].commands->dispatch(rows ? groupsX : ranges[i].groups, rows ? ranges[i].groups : 1);
+            work[i].commands->end();
+            starts[i] = std::chrono::steady_clock::now();
+            work[i].completion = shards[i].device.submit(*work[i].commands, shards[i].queueIndex);
+        }
+    } catch (...) {
+        // shards already started still use their buffers and command buffers
+        for (Work &started : work) {
+            try {
+                started.completion.wait();
+            } catch (...) {
+            }
+        }
+        throw;
+    }
+
+    // one thread blocks on each shard so that every finish is noted as it happens
+    std::vector<double> seconds(shards.size(), 0);
+    std::vector<std::thread> waiters;
+    std::atomic<bool> failed(false);
+    for (size_t i = 0; i < shards.size(); i++) {
+        if (ranges[i].groups) {
+            waiters.push_back(std::thread([&, i]() {
+                try {
+                    work[i].completion.wait();
+                } catch (...) {
+                    failed = true;
+                }
+                seconds[i] = std::max(std::chrono::duration<double>(std::chrono::steady_clock::now() - starts[i]).count(), 1e-9);
+            }));
+        }
+    }
+    for (std::thread &waiter : waiters) {
+        waiter.join();
+    }
+    if (failed) {
+        throw ERROR_DEVICES;
+    }
+
+    for (size_t i = 0; i < shards.size(); i++) {
+        for (size_t j = 0; j < work[i].buffers.size(); j++) {
+            if (buffers[j].output) {
+                work[i].buffers[j].download((char *) buffers[j].hostPtr + ranges[i].offset * buffers[j].bytesPerSlice,
+                                            ranges[i].slices * buffers[j].bytesPerSlice);
+            }
+        }
+    }
+    return seconds;
+}
+
+void ShardedDispatch::calibrate(size_t globalX, size_t globalY, std::vector<ShardedBuffer> buffers, int localX, int localY)
+{
+    // time an even split, then weigh shards by their throughput
+    for (Shard &shard : shards) {
+        shard.weight = 1.0;
+    }
+
+    std::vector<Range> ranges = split(globalY > 1 ? globalY : globalX, globalY > 1 ? localY : localX);
+    std::vector<double> seconds = run(globalX, globalY, buffers, localX, localY);
+    for (size_t i = 0; i < shards.size(); i++) {
+        shards[i].weight = ranges[i].slices ? ranges[i].slices / seconds[i] : 1.0;
+    }
+}
+
+void ShardedDispatch::dispatch(size_t globalX, size_t globalY, std::vector<ShardedBuffer> buffers, int localX, int localY)
+{
+    run(globalX, globalY, buffers, localX, localY);
+}
+
+std::vector<double> ShardedDispatch::getWeights()
+{
+    std::vector<double> weights;
+    for (Shard &shard : shards) {
+        weights.push_back(shard.weight);
+    }
+    return weights;
+}
+
+size_t ShardedDispatch::getShardCount()
+{
+    return shards.size();
+}
+
+void ShardedDispatch::destroy()
+{
+    for (Program *program : programs) {
+        delete program;
+    }
+    programs.clear();
+    shards.clear();
+}
+
+}
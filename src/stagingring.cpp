@@ -0,0 +1,179 @@
+#include "stagingring.h"
+#include "buffer.h"
+#include "queuesync.h"
+#include <algorithm>
+
+namespace vc {
+
+StagingRing::StagingRing(Device &device, size_t slotSize, unsigned int numSlots) : Device(device), slots(numSlots)
+{
+    // slots start on non-coherent atoms so that they can be flushed independently
+    VkDeviceSize atomSize = context->physicalDeviceProperties.limits.nonCoherentAtomSize;
+    this->slotSize = ((slotSize + atomSize - 1) / atomSize) * atomSize;
+
+    stagingBuffer = new Buffer(*this, this->slotSize * numSlots, true);
+    mapped = (char *) stagingBuffer->map();
+
+    // on a transfer-only queue shader accesses are ordered by semaphores instead of barriers
+    shaderAccess = context->transferQueueFamily == -1 ? VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT : 0;
+
+    VkCommandPoolCreateInfo commandPoolCreateInfo = {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+    commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    commandPoolCreateInfo.queueFamilyIndex = context->transferQueueFamily == -1 ? context->computeQueueFamily : context->transferQueueFamily;
+    if (VK_SUCCESS != vkCreateCommandPool(this->device, &commandPoolCreateInfo, nullptr, &commandPool)) {
+        throw ERROR_COMMAND;
+    }
+
+    VkCommandBufferAllocateInfo commandBufferAllocateInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+    commandBufferAllocateInfo.commandBufferCount = 1;
+    commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferAllocateInfo.commandPool = commandPool;
+    for (Slot &slot : slots) {
+        if (VK_SUCCESS != vkAllocateCommandBuffers(this->device, &commandBufferAllocateInfo, &slot.commandBuffer)) {
+            throw ERROR_COMMAND;
+        }
+    }
+}
+
+unsigned int StagingRing::acquire()
+{
+    unsigned int slot = nextSlot;
+    nextSlot = (nextSlot + 1) % slots.size();
+    slots[slot].completion.wait();
+    return slot;
+}
+
+void StagingRing::begin(unsigned int slot)
+{
+    VkCommandBufferBeginInfo commandBufferBeginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (VK_SUCCESS != vkBeginCommandBuffer(slots[slot].commandBuffer, &commandBufferBeginInfo)) {
+        throw ERROR_COMMAND;
+    }
+}
+
+void StagingRing::end(unsigned int slot)
+{
+    if (VK_SUCCESS != vkEndCommandBuffer(slots[slot].commandBuffer)) {
+        throw ERROR_COMMAND;
+    }
+
+    VkSubmitInfo submitInfo = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &slots[slot].commandBuffer;
+    // uploads wait for earlier compute work too, it may still use the buffer being overwritten
+    slots[slot].completion = context->queueSync->transferSubmit(submitInfo, true);
+}
+
+void StagingRing::upload(VkBuffer dst, const void *hostPtr, size_t byteSize, size_t offset)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    const char *source = (const char *) hostPtr;
+    while (byteSize) {
+        size_t chunkSize = std::min(byteSize, slotSize);
+        unsigned int slot = acquire();
+        memcpy(mapped + slot * slotSize, source, chunkSize);
+        stagingBuffer->flush(slot * slotSize, chunkSize);
+
+        // don't overwrite what earlier work is still reading or writing
+        begin(slot);
+        VkMemoryBarrier memoryBarrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+        memoryBarrier.srcAccessMask = (shaderAccess & VK_ACCESS_SHADER_WRITE_BIT) | VK_ACCESS_TRANSFER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(slots[slot].commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+        VkBufferCopy bufferCopy = {slot * slotSize, offset, chunkSize};
+        vkCmdCopyBuffer(slots[slot].commandBuffer, *stagingBuffer, dst, 1, &bufferCopy);
+
+        // make the copy visible to whatever is submitted after it
+        memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = shaderAccess | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier(slots[slot].commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+        end(slot);
+
+        // the host data now lives in the ring, no need to wait for the copy
+        source += chunkSize;
+        offset += chunkSize;
+        byteSize -= chunkSize;
+    }
+}
+
+void StagingRing::download(VkBuffer src, void *hostPtr, size_t byteSize, size_t offset)
+{
+    struct Chunk {
+        unsigned int slot;
+        char *destination;
+        size_t size;
+    };
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // keep as many chunks in flight as there are slots, retiring them in order
+    std::vector<Chunk> chunks;
+    char *destination = (char *) hostPtr;
+    size_t retired = 0;
+    while (retired < chunks.size() || byteSize) {
+        while (byteSize && chunks.size() - retired < slots.size()) {
+            size_t chunkSize = std::min(byteSize, slotSize);
+            unsigned int slot = acquire();
+
+            begin(slot);
+            VkMemoryBarrier memoryBarrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+            memoryBarrier.srcAccessMask = (shaderAccess & VK_ACCESS_SHADER_WRITE_BIT) | VK_ACCESS_TRANSFER_WRITE_BIT;
+            memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            vkCmdPipelineBarrier(slots[slot].commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+            VkBufferCopy bufferCopy = {offset, slot * slotSize, chunkSize};
+            vkCmdCopyBuffer(slots[slot].commandBuffer, src, *stagingBuffer, 1, &bufferCopy);
+
+            memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            memoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+            vkCmdPipelineBarrier(slots[slot].commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+            end(slot);
+
+            chunks.push_back({slot, destination, chunkSize});
+            destination += chunkSize;
+            offset += chunkSize;
+            byteSize -= chunkSize;
+        }
+
+        Chunk &chunk = chunks[retired++];
+        slots[chunk.slot].completion.wait();
+        stagingBuffer->invalidate(chunk.slot * slotSize, chunk.size);
+        memcpy(chunk.destination, mapped + chunk.slot * slotSize, chunk.size);
+    }
+}
+
+void StagingRing::synchronizeHost()
+{
+    // waits for compute work like a download does, then makes its writes visible to the host
+    std::unique_lock<std::mutex> lock(mutex);
+    unsigned int slot = acquire();
+    begin(slot);
+    VkMemoryBarrier memoryBarrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    memoryBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    memoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(slots[slot].commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    end(slot);
+    slots[slot].completion.wait();
+}
+
+void StagingRing::destroy()
+{
+    for (Slot &slot : slots) {
+        slot.completion.wait();
+        vkFreeCommandBuffers(device, commandPool, 1, &slot.commandBuffer);
+    }
+    vkDestroyCommandPool(device, commandPool, nullptr);
+
+    stagingBuffer->unmap();
+    stagingBuffer->destroy();
+    delete stagingBuffer;
+}
+
+}
@@ -0,0 +1,250 @@
+#include "streamexecutor.h"
+#include "queuesync.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+namespace vc {
+
+StreamExecutor::StreamExecutor(Device &device, Program &program, size_t chunkSize, size_t bytesPerGroup, unsigned int depth)
+    : Device(device), program(program), chunkSize(chunkSize), bytesPerGroup(bytesPerGroup), slots(depth)
+{
+    // partial workgroups would run past the end of the chunk buffers
+    if (!depth || !bytesPerGroup || chunkSize % bytesPerGroup || program.access.size() < 1 || program.access.size() > 2) {
+        throw ERROR_COMMAND;
+    }
+
+    // transfers go to the dedicated queue when there is one, mapped device memory needs no transfers
+    splitQueues = context->transferQueueFamily != -1 && !context->unifiedMemory;
+
+    // whatever was created before a failure goes again, destroy() skips what wasn't
+    try {
+        create();
+    } catch (...) {
+        destroy();
+        throw;
+    }
+}
+
+void StreamExecutor::create()
+{
+    VkCommandPoolCreateInfo commandPoolCreateInfo = {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+    commandPoolCreateInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    commandPoolCreateInfo.queueFamilyIndex = context->computeQueueFamily;
+    if (VK_SUCCESS != vkCreateCommandPool(this->device, &commandPoolCreateInfo, nullptr, &computeCommandPool)) {
+        throw ERROR_COMMAND;
+    }
+    if (splitQueues) {
+        commandPoolCreateInfo.queueFamilyIndex = context->transferQueueFamily;
+        if (VK_SUCCESS != vkCreateCommandPool(this->device, &commandPoolCreateInfo, nullptr, &transferCommandPool)) {
+            throw ERROR_COMMAND;
+        }
+    }
+
+    VkCommandBufferAllocateInfo commandBufferAllocateInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+    commandBufferAllocateInfo.commandBufferCount = 1;
+    commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    for (Slot &slot : slots) {
+        slot.input = new Buffer(*this, chunkSize);
+        slot.output = program.access.size() == 2 ? new Buffer(*this, chunkSize) : slot.input;
+        slot.stagingIn = context->unifiedMemory ? slot.input : new Buffer(*this, chunkSize, true);
+        slot.stagingOut = context->unifiedMemory ? slot.output : slot.stagingIn;
+
+        std::vector<BufferView> resources = {*slot.input};
+        if (slot.output != slot.input) {
+            resources.push_back(*slot.output);
+        }
+        slot.arguments = new Arguments(this->program, resources);
+
+        commandBufferAllocateInfo.commandPool = computeCommandPool;
+        if (VK_SUCCESS != vkAllocateCommandBuffers(this->device, &commandBufferAllocateInfo, &slot.compute)) {
+            throw ERROR_COMMAND;
+        }
+        if (splitQueues) {
+            commandBufferAllocateInfo.commandPool = transferCommandPool;
+            if (VK_SUCCESS != vkAllocateCommandBuffers(this->device, &commandBufferAllocateInfo, &slot.upload) ||
+                VK_SUCCESS != vkAllocateCommandBuffers(this->device, &commandBufferAllocateInfo, &slot.download)) {
+                throw ERROR_COMMAND;
+            }
+        }
+    }
+}
+
+void StreamExecutor::record(Slot &slot, size_t byteSize)
+{
+    VkCommandBufferBeginInfo commandBufferBeginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    commandBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VkMemoryBarrier memoryBarrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    VkBufferCopy bufferCopy = {0, 0, byteSize};
+    bool staged = slot.stagingIn != slot.input;
+
+    // on split queues QueueSync orders the three parts, otherwise barriers within one command buffer
+    if (!splitQueues && VK_SUCCESS != vkBeginCommandBuffer(slot.compute, &commandBufferBeginInfo)) {
+        throw ERROR_COMMAND;
+    }
+
+    VkCommandBuffer upload = splitQueues ? slot.upload : slot.compute;
+    if (staged) {
+        if (splitQueues && VK_SUCCESS != vkBeginCommandBuffer(upload, &commandBufferBeginInfo)) {
+            throw ERROR_COMMAND;
+        }
+        vkCmdCopyBuffer(upload, *slot.stagingIn, *slot.input, 1, &bufferCopy);
+        if (splitQueues && VK_SUCCESS != vkEndCommandBuffer(upload)) {
+            throw ERROR_COMMAND;
+        }
+    }
+
+    if (splitQueues && VK_SUCCESS != vkBeginCommandBuffer(slot.compute, &commandBufferBeginInfo)) {
+        throw ERROR_COMMAND;
+    }
+    if (staged && !splitQueues) {
+        memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(slot.compute, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                             0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    }
+    program.bindTo(slot.compute);
+    slot.arguments->bindTo(slot.compute);
+    vkCmdDispatch(slot.compute, (byteSize + bytesPerGroup - 1) / bytesPerGroup, 1, 1);
+
+    VkCommandBuffer download = splitQueues ? slot.download : slot.compute;
+    if (splitQueues) {
+        if (VK_SUCCESS != vkEndCommandBuffer(slot.compute) || VK_SUCCESS != vkBeginCommandBuffer(download, &commandBufferBeginInfo)) {
+            throw ERROR_COMMAND;
+        }
+    } else {
+        memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(slot.compute, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+                             0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    }
+    if (staged) {
+        vkCmdCopyBuffer(download, *slot.output, *slot.stagingOut, 1, &bufferCopy);
+        memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(download, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+                             0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    }
+    if (VK_SUCCESS != vkEndCommandBuffer(download)) {
+        throw ERROR_COMMAND;
+    }
+}
+
+void StreamExecutor::submit(Slot &slot, unsigned int queueIndex)
+{
+    // through QueueSync like any other work, so that the queues are never used from two threads
+    // at once and downloads through Buffer wait for the chunks still being computed
+    VkSubmitInfo submitInfo = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    submitInfo.commandBufferCount = 1;
+    if (!splitQueues) {
+        submitInfo.pCommandBuffers = &slot.compute;
+        slot.completion = context->queueSync->computeSubmit(queueIndex, submitInfo);
+        return;
+    }
+
+    // QueueSync orders the compute part after the upload and the download after the compute part.
+    // The upload needs no wait on earlier compute work, the slot was retired before it was recorded
+    submitInfo.pCommandBuffers = &slot.upload;
+    context->queueSync->transferSubmit(submitInfo, false);
+    submitInfo.pCommandBuffers = &slot.compute;
+    context->queueSync->computeSubmit(queueIndex, submitInfo);
+    submitInfo.pCommandBuffers = &slot.download;
+    slot.completion = context->queueSync->transferSubmit(submitInfo, true);
+}
+
+void StreamExecutor::retire(Slot &slot)
+{
+    if (!slot.size) {
+        return;
+    }
+
+    // the download is the last part of a chunk, its completion frees the whole slot
+    slot.completion.wait();
+    slot.stagingOut->invalidate(0, slot.size);
+    memcpy(slot.destination, slot.stagingOut->map(), slot.size);
+    slot.size = 0;
+}
+
+void StreamExecutor::run(const void *input, size_t inputSize, void *output, size_t outputSize)
+{
+    // in place is fine, but a shifted output would overwrite input not yet uploaded
+    uintptr_t in = (uintptr_t) input, out = (uintptr_t) output;
+    if (outputSize < inputSize || (in != out && in < out + inputSize && out < in + inputSize)) {
+        throw ERROR_MALLOC;
+    }
+    size_t byteSize = inputSize;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // while the device works on the chunks in flight the host fills and drains the others
+    size_t chunk = 0;
+    for (size_t offset = 0; offset < byteSize; offset += chunkSize, chunk++) {
+        Slot &slot = slots[chunk % slots.size()];
+        retire(slot);
+
+        size_t size = std::min(chunkSize, byteSize - offset);
+        memcpy(slot.stagingIn->map(), (const char *) input + offset, size);
+        slot.stagingIn->flush(0, size);
+        record(slot, size);
+        submit(slot, chunk % context->numComputeQueues);
+        slot.destination = (char *) output + offset;
+        slot.size = size;
+    }
+
+    for (size_t i = 0; i < slots.size(); i++) {
+        retire(slots[(chunk + i) % slots.size()]);
+    }
+
+    throughput = byteSize / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+double StreamExecutor::getThroughput()
+{
+    return throughput;
+}
+
+void StreamExecutor::destroy()
+{
+    for (Slot &slot : slots) {
+        retire(slot);
+        slot.completion.wait();
+        if (slot.compute) {
+            vkFreeCommandBuffers(device, computeCommandPool, 1, &slot.compute);
+        }
+        if (slot.upload) {
+            vkFreeCommandBuffers(device, transferCommandPool, 1, &slot.upload);
+        }
+        if (slot.download) {
+            vkFreeCommandBuffers(device, transferCommandPool, 1, &slot.download);
+        }
+        slot.compute = slot.upload = slot.download = VK_NULL_HANDLE;
+
+        if (slot.arguments) {
+            slot.arguments->destroy();
+            delete slot.arguments;
+        }
+        if (slot.stagingIn && slot.stagingIn != slot.input) {
+            slot.stagingIn->destroy();
+            delete slot.stagingIn;
+        }
+        if (slot.output && slot.output != slot.input) {
+            slot.output->destroy();
+            delete slot.output;
+        }
+        if (slot.input) {
+            slot.input->destroy();
+            delete slot.input;
+        }
+        slot = Slot();
+    }
+    if (computeCommandPool) {
+        vkDestroyCommandPool(device, computeCommandPool, nullptr);
+        computeCommandPool = VK_NULL_HANDLE;
+    }
+    if (transferCommandPool) {
+        vkDestroyCommandPool(device, transferCommandPool, nullptr);
+        transferCommandPool = VK_NULL_HANDLE;
+    }
+}
+
+}
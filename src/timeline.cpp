@@ -0,0 +1,55 @@
+#include "timeline.h"
+
+namespace vc {
+
+Timeline::Timeline(Device &device, uint64_t initialValue) : Device(device)
+{
+    if (!context->timelineWait) {
+        throw ERROR_DEVICES;
+    }
+
+    VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO};
+    semaphoreTypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    semaphoreTypeCreateInfo.initialValue = initialValue;
+    VkSemaphoreCreateInfo semaphoreCreateInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+    semaphoreCreateInfo.pNext = &semaphoreTypeCreateInfo;
+    if (VK_SUCCESS != vkCreateSemaphore(this->device, &semaphoreCreateInfo, nullptr, &semaphore)) {
+        throw ERROR_DEVICES;
+    }
+}
+
+SyncPoint Timeline::at(uint64_t value)
+{
+    return {semaphore, value};
+}
+
+uint64_t Timeline::getValue()
+{
+    uint64_t value;
+    if (VK_SUCCESS != context->timelineValue(device, semaphore, &value)) {
+        throw ERROR_DEVICES;
+    }
+    return value;
+}
+
+bool Timeline::wait(uint64_t value, uint64_t timeout)
+{
+    return Device::wait(at(value), timeout);
+}
+
+void Timeline::signal(uint64_t value)
+{
+    VkSemaphoreSignalInfo semaphoreSignalInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO};
+    semaphoreSignalInfo.semaphore = semaphore;
+    semaphoreSignalInfo.value = value;
+    if (VK_SUCCESS != context->timelineSignal(device, &semaphoreSignalInfo)) {
+        throw ERROR_DEVICES;
+    }
+}
+
+void Timeline::destroy()
+{
+    vkDestroySemaphore(device, semaphore, nullptr);
+}
+
+}